@@ -0,0 +1,164 @@
+#include "ast.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// destroys each node, dropping the lists folded nodes hold, the capacity stays
+void Ast::clear() {
+    nodes.clear();
+    children.clear();
+    shared.clear();
+}
+
+bool Ast::empty() const {
+    return nodes.empty();
+}
+
+// every node but the root is the child of one other node
+void Ast::reserve(std::size_t count) {
+    nodes.reserve(count);
+    children.reserve(count);
+}
+
+std::uint32_t Ast::root() const {
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+}
+
+void Ast::setSharing(bool enabled) {
+    share = enabled;
+}
+
+bool Ast::sharing() const {
+    return share;
+}
+
+// mix value into hash
+static std::uint64_t mix(std::uint64_t hash, std::uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// bytes of the payload of a graphic atom, doubles without padding, 0 for
+// other types
+static std::size_t graphic_size(Type type) {
+    switch (type) {
+    case PointType:
+        return sizeof(Point);
+    case LineType:
+        return sizeof(Line);
+    case ArcType:
+        return sizeof(Arcn);
+    case RectType:
+        return sizeof(Rectt);
+    case FillRectType:
+        return sizeof(FillRectt);
+    case EllipseType:
+        return sizeof(Ellipsee);
+    default:
+        return 0;
+    }
+}
+
+// hash of the atoms a parse produces or folds to, bit exact for numbers
+// and graphics
+static std::uint64_t atom_hash(const Atom& atom) {
+    std::uint64_t value = 0;
+    if (std::size_t size = graphic_size(atom.type)) {
+        std::uint64_t hash = atom.type;
+        for (std::size_t offset = 0; offset < size; offset += sizeof(value)) {
+            std::memcpy(&value, reinterpret_cast<const char*>(&atom.value) + offset, sizeof(value));
+            hash = mix(hash, value);
+        }
+        return hash;
+    }
+    switch (atom.type) {
+    case NumberType:
+        std::memcpy(&value, &atom.value.num_value, sizeof(value));
+        break;
+    case BooleanType:
+        value = atom.value.bool_value;
+        break;
+    case SymbolType:
+        value = atom.value.sym_value.id;
+        break;
+    default:
+        break;
+    }
+    return mix(atom.type, value);
+}
+
+// true if a and b are the same literal, symbol or graphic, the atoms that
+// are shared. Lists are not: they are never literals and are not folded
+static bool same_atom(const Atom& a, const Atom& b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    if (std::size_t size = graphic_size(a.type)) {
+        return std::memcmp(&a.value, &b.value, size) == 0;
+    }
+    switch (a.type) {
+    case NumberType:
+        return std::memcmp(&a.value.num_value, &b.value.num_value, sizeof(double)) == 0;
+    case BooleanType:
+        return a.value.bool_value == b.value.bool_value;
+    case SymbolType:
+        return a.value.sym_value == b.value.sym_value;
+    default:
+        return false;
+    }
+}
+
+// structural hash of a node with the given head and children
+static std::uint64_t node_hash(const std::vector<AstNode>& nodes, const Atom& head, const std::uint32_t* child_nodes, std::uint32_t count) {
+    std::uint64_t hash = mix(atom_hash(head), count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        hash = mix(hash, nodes[child_nodes[i]].hash);
+    }
+    return hash;
+}
+
+std::uint32_t Ast::add(const Atom& head, const std::uint32_t* child_nodes, std::uint32_t count) {
+    std::uint64_t hash = node_hash(nodes, head, child_nodes, count);
+
+    if (share) { // children are shared already, so equal nodes have equal child indices
+        auto range = shared.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const AstNode& node = nodes[it->second];
+            if (node.count == count && same_atom(node.head, head) &&
+                std::equal(child_nodes, child_nodes + count, children.begin() + node.first)) {
+                return it->second;
+            }
+        }
+    }
+
+    AstNode node;
+    node.head = head;
+    node.first = static_cast<std::uint32_t>(children.size());
+    node.count = count;
+    node.proc = nullptr;
+    node.type = NoneType;
+    node.hash = hash;
+    children.insert(children.end(), child_nodes, child_nodes + count);
+    nodes.push_back(node);
+    if (share) {
+        shared.emplace(hash, root());
+    }
+    return root();
+}
+
+void Ast::replace(std::uint32_t index, const Atom& value) {
+    AstNode& node = nodes[index];
+    node.head = value;
+    node.count = 0;
+    node.proc = nullptr;
+    node.type = value.type;
+    node.hash = node_hash(nodes, value, nullptr, 0);
+    if (share) { // an equal leaf added later shares the folded node
+        shared.emplace(node.hash, index);
+    }
+}
+
+void Ast::rehash(std::uint32_t index) {
+    AstNode& node = nodes[index];
+    node.hash = node_hash(nodes, node.head, children.data() + node.first, node.count);
+}
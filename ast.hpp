@@ -0,0 +1,69 @@
+#ifndef AST_HPP
+#define AST_HPP
+
+// system includes
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+// module includes
+#include "expression.hpp"
+
+// An AstNode is an atom called the head with a range of child node
+// indices in Ast::children, the children are the operands of the head
+struct AstNode {
+    Atom head;
+    std::uint32_t first; // offset of the first child index in Ast::children
+    std::uint32_t count; // number of children
+    Procedure proc;      // builtin the head resolved to, nullptr if not resolved
+    Type type;           // type of the value of the node if proved, else NoneType
+    std::uint64_t hash;  // structural hash of the subtree, equal subtrees hash equal
+};
+
+// An Ast stores the nodes of one parsed form in a flat array, children
+// before their parent (postfix order) so the root is the last node.
+// Clearing the Ast keeps the storage for the next form. It is linear in
+// the nodes, not O(1): an Atom may hold a reference to list storage, as
+// a node folded to a list does, and clearing releases it.
+// With sharing on, add hash-conses: a subtree equal to one added before
+// returns the existing node, so repeated subexpressions are stored once
+// and the Ast is a DAG where equal subtrees have the same index
+class Ast {
+public:
+    std::vector<AstNode> nodes;
+    std::vector<std::uint32_t> children;
+
+    void clear();
+    bool empty() const;
+
+    // turn hash-consing on or off for the nodes added after
+    void setSharing(bool enabled);
+    bool sharing() const;
+
+    // make room for nodes nodes and their child links, so a parse of a
+    // known token count appends without reallocating
+    void reserve(std::size_t nodes);
+
+    // index of the root node, the last one added
+    std::uint32_t root() const;
+
+    // append a node with the given children, returns its index
+    std::uint32_t add(const Atom& head, const std::uint32_t* child_nodes, std::uint32_t count);
+
+    // the i-th child of node
+    const AstNode& child(const AstNode& node, std::uint32_t i) const {
+        return nodes[children[node.first + i]];
+    }
+
+    // make node index a leaf holding value, as when a call is folded
+    void replace(std::uint32_t index, const Atom& value);
+
+    // recompute the hash of node index after its children were replaced
+    void rehash(std::uint32_t index);
+
+private:
+    bool share = false;
+    std::unordered_multimap<std::uint64_t, std::uint32_t> shared; // node hash to index
+};
+
+#endif
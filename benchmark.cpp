@@ -0,0 +1,372 @@
+// micro benchmarks for the interpreter, run with no arguments for all of them
+// or with the names of the benchmarks to run, e.g. ./benchmark tokenize
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+
+#include "test_config.hpp"
+#include "tokenizer.hpp"
+#include "interpreter.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+// seconds elapsed since start
+static double elapsed(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const std::string& name, double count, const std::string& unit, double seconds) {
+    std::cout << "  " << name << ": " << count / seconds << " " << unit << "/s"
+              << " (" << seconds * 1000 << " ms)" << std::endl;
+}
+
+// a generated script of the kind our drawing tools emit, n line segments
+static std::string coordinate_script(std::size_t n) {
+    std::ostringstream oss;
+    oss << "(";
+    for (std::size_t i = 0; i < n; ++i) {
+        oss << "(((" << i << ".5 -" << i % 97 << " point) (" << i % 13 << "e2 "
+            << i * 0.25 << " point) line) draw) ; segment\n";
+    }
+    oss << "begin)";
+    return oss.str();
+}
+
+static void bench_tokenize_script(const std::string& script) {
+    // stream tokenizer, one std::string per token
+    Clock::time_point start = Clock::now();
+    std::istringstream iss(script);
+    TokenSequenceType stream_tokens = tokenize(iss);
+    report("istream tokenize", stream_tokens.size(), "tokens", elapsed(start));
+
+    // buffer tokenizer, tokens are ranges into the script
+    start = Clock::now();
+    TokenViewSequenceType buffer_tokens;
+    tokenize(script.data(), script.size(), buffer_tokens);
+    report("buffer tokenize", buffer_tokens.size(), "tokens", elapsed(start));
+
+    // buffer tokenizer reusing the token storage, as Interpreter::parse does
+    const char* names[] = { "scalar", "sse2", "avx2" };
+    for (TokenScanner scanner : { ScalarScanner, SSE2Scanner, AVX2Scanner }) {
+        if (scanner > best_token_scanner()) {
+            continue;
+        }
+        start = Clock::now();
+        buffer_tokens.clear();
+        tokenize(script.data(), script.size(), buffer_tokens, scanner);
+        report(std::string("buffer tokenize, reused, ") + names[scanner], buffer_tokens.size(), "tokens", elapsed(start));
+    }
+
+    if (stream_tokens.size() != buffer_tokens.size()) {
+        std::cout << "  token count mismatch" << std::endl;
+    }
+}
+
+static void bench_tokenize() {
+    std::cout << "tokenize, dense coordinates" << std::endl;
+    bench_tokenize_script(coordinate_script(200000));
+
+    // indented and commented, like the hand written scripts in tests/
+    std::cout << "tokenize, indented and commented" << std::endl;
+    std::ostringstream oss;
+    for (std::size_t i = 0; i < 100000; ++i) {
+        oss << "        ; ---------------------------------------- shape " << i << "\r\n"
+            << "        (((" << i << " 10 point)    (" << i % 13 << " 20 point)    line)    draw)\r\n";
+    }
+    bench_tokenize_script(oss.str());
+}
+
+static void bench_numbers() {
+    std::cout << "numbers" << std::endl;
+    std::string script = coordinate_script(200000);
+    TokenViewSequenceType tokens;
+    tokenize(script.data(), script.size(), tokens);
+
+    // the previous approach, a stream per token
+    Clock::time_point start = Clock::now();
+    double sum = 0;
+    for (const Token& token : tokens) {
+        std::istringstream iss(script.substr(token.offset, token.length));
+        double value;
+        if (iss >> value) {
+            sum += value;
+        }
+    }
+    report("istringstream", tokens.size(), "tokens", elapsed(start));
+
+    start = Clock::now();
+    double check = 0;
+    for (const Token& token : tokens) {
+        double value;
+        if (scan_number(script.data() + token.offset, token.length, value) != 0) {
+            check += value;
+        }
+    }
+    report("scan_number", tokens.size(), "tokens", elapsed(start));
+
+    if (sum != check) {
+        std::cout << "  sum mismatch" << std::endl;
+    }
+}
+
+static void bench_stream() {
+    std::cout << "stream" << std::endl;
+
+    // many small top-level forms, as in a generated script
+    std::ostringstream oss;
+    for (std::size_t i = 0; i < 200000; ++i) {
+        oss << "(((" << i << " " << i % 97 << " point) (" << i % 13 << " " << i * 0.25 << " point) line) draw)\n";
+    }
+    std::string script = oss.str();
+
+    std::istringstream iss(script);
+    FormReader reader(iss);
+    Interpreter interpreter;
+
+    Clock::time_point start = Clock::now();
+    while (interpreter.parseNext(reader)) {
+        interpreter.eval();
+    }
+    double seconds = elapsed(start);
+    report("parse and eval", reader.formsRead(), "forms", seconds);
+    report("parse and eval", reader.bytesConsumed() / 1e6, "MB", seconds);
+}
+
+static void bench_eval() {
+    std::cout << "eval" << std::endl;
+
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        // symbol heavy arithmetic, evaluated repeatedly
+        std::istringstream iss("((x 3 define) (y 4 define) (r ((x x *) (y y *) +) define)"
+                               " ((r sqrt) ((x y arctan) sin) *) begin)");
+        Interpreter interpreter;
+        interpreter.setEvalMode(mode);
+        interpreter.parse(iss);
+
+        const std::size_t n = 200000;
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            interpreter.eval();
+        }
+        report(mode == TreeWalkMode ? "tree walker" : "bytecode vm", n, "programs", elapsed(start));
+    }
+}
+
+static void bench_corpus() {
+    std::cout << "corpus" << std::endl;
+
+    // the scripts in tests/ that evaluate, each run many times
+    std::vector<std::string> files = { "test2.slp", "test3.slp", "test4.slp", "test5.slp", "test_arc.slp", "test_arc_simple.slp", "test_crlf.slp" };
+    const std::size_t runs = 20000;
+
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        std::size_t count = 0;
+        double seconds = 0;
+        for (const auto& file : files) {
+            std::ifstream ifs(TEST_FILE_DIR + "/" + file);
+            Interpreter interpreter;
+            interpreter.setEvalMode(mode);
+            if (!interpreter.parse(ifs)) {
+                continue;
+            }
+
+            Clock::time_point start = Clock::now();
+            for (std::size_t i = 0; i < runs; ++i) {
+                interpreter.eval();
+            }
+            seconds += elapsed(start);
+            count += runs;
+        }
+        report(mode == TreeWalkMode ? "tree walker" : "bytecode vm", count, "scripts", seconds);
+    }
+}
+
+static void bench_repl() {
+    std::cout << "repl" << std::endl;
+
+    // a geometry block entered again and again through parseAndEvaluate,
+    // without draw, which has effects and is never cached
+    std::string block = "(";
+    for (int i = 0; i < 200; ++i) {
+        block += "(((" + std::to_string(i) + " pi *) cos) ((" + std::to_string(i) + " 2 /) sin) point) ";
+    }
+    block += "begin)";
+    const std::size_t runs = 2000;
+
+    for (bool caching : { false, true }) {
+        Interpreter interpreter;
+        interpreter.setResultCache(caching);
+
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < runs; ++i) {
+            interpreter.parseAndEvaluate(block);
+        }
+        report(caching ? "cached" : "uncached", runs, "forms", elapsed(start));
+    }
+}
+
+static void bench_lists() {
+    std::cout << "lists" << std::endl;
+
+    // sin(x * i / 1000) for i < 1000, once as 1000 interpreted forms and
+    // once as element-wise list arithmetic. x is defined so nothing folds
+    const int elements = 1000;
+    std::string forms = "((x 1 define) ";
+    for (int i = 0; i < elements; ++i) {
+        forms += "((x " + std::to_string(i / 1000.) + " *) sin) ";
+    }
+    forms += "begin)";
+    std::string lists = "((x 1 define) ((((0 " + std::to_string(elements) + " range) x *) 1000 /) sin) begin)";
+    const std::size_t runs = 2000;
+
+    for (bool use_lists : { false, true }) {
+        std::istringstream iss(use_lists ? lists : forms);
+        Interpreter interpreter;
+        interpreter.setEvalMode(BytecodeMode);
+        interpreter.parse(iss);
+
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < runs; ++i) {
+            interpreter.eval();
+        }
+        report(use_lists ? "list kernels" : "scalar forms", double(runs) * elements, "elements", elapsed(start));
+    }
+}
+
+static void bench_invalid() {
+    std::cout << "invalid" << std::endl;
+
+    // user input of which most forms do not parse or fail to evaluate
+    std::vector<std::string> forms = {
+        "(1 0 /)",
+        "(x 1 +)",
+        "(1 2 foo)",
+        "((1 2 <) 3",
+        "(1 true +)",
+        "((1 2 3 range) (1 2 range) +)",
+        "(((0 0 point) (1 1 point) rect) 1 2 300 fill_rect)",
+        "(-1 sqrt)",
+        "((1 2 +) 3 *)",
+        "((0 0 point) (3 4 point) line)",
+    };
+    const std::size_t runs = 50000;
+
+    // parse errors are printed by parseAndEvaluate, keep them off the report
+    std::ostringstream discard;
+    std::streambuf* out = std::cout.rdbuf();
+
+    for (bool throwing : { true, false }) {
+        Interpreter interpreter;
+        interpreter.setResultCache(false);
+        std::size_t failed = 0;
+
+        std::cout.rdbuf(discard.rdbuf());
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < runs; ++i) {
+            const std::string& form = forms[i % forms.size()];
+            if (throwing) {
+                try {
+                    interpreter.parseAndEvaluate(form);
+                }
+                catch (const InterpreterSemanticError&) {
+                    ++failed;
+                }
+                discard.str(std::string());
+            }
+            else if (!interpreter.tryParseAndEvaluate(form).ok()) {
+                ++failed;
+            }
+        }
+        double seconds = elapsed(start);
+        std::cout.rdbuf(out);
+
+        report(throwing ? "exceptions" : "error codes", runs, "forms", seconds);
+        std::cout << "    " << failed << " of " << runs << " rejected" << std::endl;
+    }
+}
+
+static void bench_parallel() {
+    std::cout << "parallel" << std::endl;
+
+    // a drawing of independent scaled segments, scale is defined so the
+    // children do not fold to constants
+    const int children = 20000;
+    std::string script = "((scale 2 define) ";
+    for (int i = 0; i < children; ++i) {
+        std::string n = std::to_string(i);
+        script += "(((((" + n + " scale *) sin) (" + n + " 3 /) point) ((" + n + " scale /) 1 point) line) draw) ";
+    }
+    script += "begin)";
+    const std::size_t runs = 20;
+
+    std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= cores; threads *= 2) {
+        std::istringstream iss(script);
+        Interpreter interpreter;
+        interpreter.setThreads(threads);
+        interpreter.parse(iss);
+
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < runs; ++i) {
+            interpreter.eval();
+        }
+        report(std::to_string(threads) + " threads", double(runs) * children, "children", elapsed(start));
+    }
+}
+
+static void bench_construct() {
+    std::cout << "construct" << std::endl;
+
+    // short-lived sessions, each evaluating one small form
+    const std::size_t n = 200000;
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        Interpreter interpreter;
+    }
+    report("interpreter", n, "constructions", elapsed(start));
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        Interpreter interpreter;
+        interpreter.parseAndEvaluate("((1 2 +) 3 *)");
+    }
+    report("session", n, "sessions", elapsed(start));
+}
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    { "tokenize", bench_tokenize },
+    { "numbers", bench_numbers },
+    { "stream", bench_stream },
+    { "eval", bench_eval },
+    { "corpus", bench_corpus },
+    { "repl", bench_repl },
+    { "lists", bench_lists },
+    { "invalid", bench_invalid },
+    { "parallel", bench_parallel },
+    { "construct", bench_construct },
+};
+
+int main(int argc, char* argv[]) {
+    for (const Benchmark& b : benchmarks) {
+        bool selected = (argc == 1);
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || std::strcmp(argv[i], b.name) == 0;
+        }
+        if (selected) {
+            b.run();
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+// benchmark of drawing many items on the canvas, adding them one by one as
+// the drawGraphic signal does against adding them in batches as drawGraphics
+// does, of panning a view of them as items against as display lists at
+// several zooms, and of itemAt and repainting with and without the scene's
+// index. Run with no arguments for 10k, 100k and 1M items or with the item
+// counts, e.g. ./benchmark_gui 250000. Runs offscreen unless QT_QPA_PLATFORM
+// is set
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <QApplication>
+#include <QGraphicsLineItem>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QPainter>
+#include <QVector>
+
+#include "canvas_widget.hpp"
+#include "display_list_item.hpp"
+#include "qt_interpreter.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+// seconds elapsed since start
+static double elapsed(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const std::string& name, double count, const std::string& unit, double seconds) {
+    std::cout << "  " << name << ": " << count / seconds << " " << unit << "/s"
+              << " (" << seconds * 1000 << " ms)" << std::endl;
+}
+
+// line segment i of a drawing spread over the canvas
+static QLineF line_of(int i) {
+    double x = (i % 1000) * 4.0;
+    double y = (i / 1000) * 4.0;
+    return QLineF(x, y, x + 3.0, y + (i % 7));
+}
+
+// n line segments as items, the canvas takes ownership
+static QVector<QGraphicsItem*> make_lines(int n) {
+    QVector<QGraphicsItem*> items;
+    items.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        auto* line = new QGraphicsLineItem(line_of(i));
+        line->setPen(QPen(Qt::black, 3));
+        items.push_back(line);
+    }
+    return items;
+}
+
+// n line segments in display lists of DrawBatch segments each
+static QVector<QGraphicsItem*> make_lists(int n) {
+    QVector<QGraphicsItem*> items;
+    for (int first = 0; first < n; first += QtInterpreter::DrawBatch) {
+        auto* list = new DisplayListItem();
+        for (int i = first; i < n && i < first + QtInterpreter::DrawBatch; ++i) {
+            list->addLine(line_of(i));
+        }
+        items.push_back(list);
+    }
+    return items;
+}
+
+// median time of repainting view at each of frames steps of a pan to the
+// right by a tenth of what it shows
+static double pan(QGraphicsView& view, int frames) {
+    QRectF shown = view.mapToScene(view.viewport()->rect()).boundingRect();
+    std::vector<double> times;
+    for (int k = 0; k < frames; ++k) {
+        view.centerOn(shown.center() + QPointF(k * shown.width() / 10, 0));
+        Clock::time_point start = Clock::now();
+        view.viewport()->grab();
+        times.push_back(elapsed(start));
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// time repainting a view of all of a drawing and panning it zoomed in
+static void bench_paint(int n) {
+    std::cout << "paint " << n << " lines" << std::endl;
+
+    const char* names[] = { "items", "display lists" };
+    for (int lists = 0; lists < 2; ++lists) {
+        QGraphicsScene scene;
+        for (QGraphicsItem* item : lists ? make_lists(n) : make_lines(n)) {
+            scene.addItem(item);
+        }
+        QGraphicsView view(&scene);
+        view.resize(1024, 768);
+        view.show();
+        QRectF all = scene.itemsBoundingRect();
+
+        for (int zoom : { 1, 10, 100 }) {
+            view.resetTransform();
+            view.fitInView(all, Qt::KeepAspectRatio);
+            view.scale(zoom, zoom);
+            double seconds = pan(view, zoom == 1 ? 3 : 10);
+            report(std::string(names[lists]) + ", zoom " + std::to_string(zoom) + "x, median frame", 1, "frames", seconds);
+        }
+
+        Clock::time_point start = Clock::now();
+        int hits = 0;
+        for (int i = 0; i < 1000; ++i) {
+            hits += scene.itemAt(line_of(i * (n / 1000)).center(), QTransform()) != nullptr;
+        }
+        report(std::string(names[lists]) + ", itemAt (" + std::to_string(hits) + " hits)", 1000, "queries", elapsed(start));
+    }
+}
+
+// time itemAt and repainting the view of a canvas of n lines, one in a
+// hundred of them long, with the scene's index and without
+static void bench_index(int n) {
+    std::cout << "index " << n << " lines" << std::endl;
+
+    const char* names[] = { "scene BSP tree", "no index" };
+    for (int method = 0; method < 2; ++method) {
+        CanvasWidget canvas;
+        canvas.resize(1024, 768);
+        canvas.show();
+        canvas.setSceneIndexing(method == 0);
+
+        QVector<QGraphicsItem*> items = make_lines(n);
+        for (int i = 0; i < n; i += 100) {
+            double x = line_of(i).x1();
+            auto* line = new QGraphicsLineItem(x, 0, 4000 - x, n / 250.0);
+            line->setPen(QPen(Qt::black, 3));
+            items.push_back(line);
+        }
+        Clock::time_point start = Clock::now();
+        canvas.addGraphics(items);
+        QApplication::processEvents();
+        report(std::string(names[method]) + ", insert", items.size(), "items", elapsed(start));
+
+        start = Clock::now();
+        QGraphicsScene* scene = canvas.findChild<QGraphicsScene*>();
+        int hits = 0;
+        for (int i = 0; i < 1000; ++i) {
+            hits += scene->itemAt(line_of(i * (n / 1000)).center(), QTransform()) != nullptr;
+        }
+        report(std::string(names[method]) + ", itemAt (" + std::to_string(hits) + " hits)", 1000, "queries", elapsed(start));
+
+        start = Clock::now();
+        canvas.grab();
+        report(std::string(names[method]) + ", repaint", 1, "repaints", elapsed(start));
+    }
+}
+
+// time adding the items and painting the canvas once they are all in
+static void bench_insert(int n) {
+    std::cout << "insert " << n << " lines" << std::endl;
+
+    {
+        CanvasWidget canvas;
+        canvas.show();
+        QVector<QGraphicsItem*> items = make_lines(n);
+        Clock::time_point start = Clock::now();
+        for (QGraphicsItem* item : items) {
+            canvas.addGraphic(item);
+        }
+        QApplication::processEvents();
+        report("addGraphic, item by item", n, "items", elapsed(start));
+    }
+
+    {
+        CanvasWidget canvas;
+        canvas.show();
+        QVector<QGraphicsItem*> items = make_lines(n);
+        Clock::time_point start = Clock::now();
+        for (int first = 0; first < n; first += QtInterpreter::DrawBatch) {
+            canvas.addGraphics(items.mid(first, QtInterpreter::DrawBatch));
+        }
+        QApplication::processEvents();
+        report("addGraphics, batches of " + std::to_string(QtInterpreter::DrawBatch), n, "items", elapsed(start));
+    }
+
+    {
+        CanvasWidget canvas;
+        canvas.show();
+        QVector<QGraphicsItem*> items = make_lines(n);
+        Clock::time_point start = Clock::now();
+        canvas.addGraphics(items);
+        QApplication::processEvents();
+        report("addGraphics, one batch", n, "items", elapsed(start));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    std::vector<int> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back(std::atoi(argv[i]));
+    }
+    if (counts.empty()) {
+        counts = { 10000, 100000, 1000000 };
+    }
+    for (int n : counts) {
+        bench_insert(n);
+        bench_paint(n);
+        bench_index(n);
+    }
+    return EXIT_SUCCESS;
+}
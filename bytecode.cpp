@@ -0,0 +1,243 @@
+#include "bytecode.hpp"
+#include "interpreter_semantic_error.hpp"
+
+void Program::clear() {
+    code.clear();
+    constants.clear();
+    errors.clear();
+    calls.clear();
+}
+
+// helper to append an instruction, returns its index
+static std::uint32_t emit(Program& program, OpCode op, std::uint32_t operand = 0, std::uint32_t count = 0) {
+    program.code.push_back(Instruction{ op, operand, count });
+    return static_cast<std::uint32_t>(program.code.size() - 1);
+}
+
+// helper to append a FailOp raising the error code with text or symbol
+template <class Detail>
+static void emit_fail(Program& program, ErrorCode code, Detail detail) {
+    program.errors.push_back(EvalError());
+    program.errors.back().fail(code, detail);
+    emit(program, FailOp, static_cast<std::uint32_t>(program.errors.size() - 1));
+}
+
+// a node being compiled, step counts its children done so far, jump is
+// the pending jump instruction of an if
+struct CompileFrame {
+    const AstNode* node;
+    std::uint32_t step;
+    std::uint32_t jump;
+};
+
+// nodes are compiled from an explicit stack, so the nesting depth is not
+// limited by the C++ stack. The code of each node leaves exactly one value
+// on the stack when run
+void compile(const Ast& ast, std::uint32_t root, const Environment& env, Program& program) {
+    program.clear();
+    program.version = env.version();
+
+    std::vector<CompileFrame> frames;
+    frames.push_back(CompileFrame{ &ast.nodes[root], 0, 0 });
+
+    while (!frames.empty()) {
+        CompileFrame& frame = frames.back();
+        const AstNode& exp = *frame.node;
+        std::uint32_t step = frame.step++;
+
+        if (exp.count == 0) {
+            if (exp.head.type == SymbolType) { // look up the symbol in the env
+                emit(program, LoadSymbolOp, exp.head.value.sym_value.id);
+            }
+            else { // number or boolean literal
+                program.constants.push_back(exp.head);
+                emit(program, PushConstOp, static_cast<std::uint32_t>(program.constants.size() - 1));
+            }
+            frames.pop_back();
+            continue;
+        }
+
+        if (exp.head.type != SymbolType) {
+            emit_fail(program, SpecialFormError, "Error: Operator must be a symbol");
+            frames.pop_back();
+            continue;
+        }
+
+        const Symbol& op = exp.head.value.sym_value;
+
+        if (op.id == DefineId) {
+            if (exp.count != 2) {
+                emit_fail(program, SpecialFormError, "Error: 'define' expects exactly two arguments");
+                frames.pop_back();
+                continue;
+            }
+
+            // the value is evaluated before the symbol is checked
+            if (step == 0) {
+                frames.push_back(CompileFrame{ &ast.child(exp, 1), 0, 0 });
+                continue;
+            }
+
+            const AstNode& symbolNode = ast.child(exp, 0);
+            if (symbolNode.head.type != SymbolType) {
+                emit_fail(program, SpecialFormError, "Error: 'define' requires a symbol as the first argument");
+            }
+            else if (Environment::isKeyword(symbolNode.head.value.sym_value)) {
+                emit_fail(program, SpecialFormError, "Error: Invalid symbol, symbol is a keyword");
+            }
+            else {
+                emit(program, DefineStoreOp, symbolNode.head.value.sym_value.id);
+            }
+            frames.pop_back();
+            continue;
+        }
+
+        if (op.id == BeginId) { // keep only the value of the last expression
+            if (step == exp.count) {
+                frames.pop_back();
+                continue;
+            }
+            if (step != 0) {
+                emit(program, PopOp);
+            }
+            frames.push_back(CompileFrame{ &ast.child(exp, step), 0, 0 });
+            continue;
+        }
+
+        if (op.id == IfId) {
+            if (exp.count != 3) {
+                emit_fail(program, SpecialFormError, "Error: 'if' expects exactly three arguments");
+                frames.pop_back();
+                continue;
+            }
+
+            switch (step) {
+            case 0: // condition
+                break;
+            case 1: // then branch
+                frame.jump = emit(program, JumpIfFalseOp);
+                break;
+            case 2: { // else branch
+                std::uint32_t jump_else = frame.jump;
+                frame.jump = emit(program, JumpOp);
+                program.code[jump_else].operand = static_cast<std::uint32_t>(program.code.size());
+                break;
+            }
+            default:
+                program.code[frame.jump].operand = static_cast<std::uint32_t>(program.code.size());
+                frames.pop_back();
+                continue;
+            }
+            frames.push_back(CompileFrame{ &ast.child(exp, step), 0, 0 });
+            continue;
+        }
+
+        // keyword bindings cannot be redefined from the language, so the
+        // procedure is known now
+        if (step == 0 && !env.isProcedure(op)) {
+            emit_fail(program, UnknownProcedureError, op.id);
+            frames.pop_back();
+            continue;
+        }
+
+        if (step < exp.count) {
+            frames.push_back(CompileFrame{ &ast.child(exp, step), 0, 0 });
+            continue;
+        }
+
+        program.calls.push_back(Call{ op.id, exp.proc });
+        emit(program, CallBuiltinOp, static_cast<std::uint32_t>(program.calls.size() - 1), exp.count);
+        frames.pop_back();
+    }
+}
+
+VirtualMachine::VirtualMachine(GeometrySink* sink) : sink(sink) {
+}
+
+Expression VirtualMachine::run(const Program& program, Environment& env) {
+    Atom result;
+    EvalError error;
+    if (!run(program, env, result, error)) {
+        throw InterpreterSemanticError(error.message());
+    }
+    return Expression(result);
+}
+
+bool VirtualMachine::run(const Program& program, Environment& env, Atom& result, EvalError& error) {
+    stack.clear();
+
+    const Instruction* code = program.code.data();
+    std::uint32_t size = static_cast<std::uint32_t>(program.code.size());
+
+    for (std::uint32_t pc = 0; pc < size; ++pc) {
+        const Instruction& ins = code[pc];
+
+        switch (ins.op) {
+        case PushConstOp:
+            stack.push_back(program.constants[ins.operand]);
+            break;
+
+        case LoadSymbolOp:
+            stack.emplace_back();
+            if (!env.get(Symbol::fromId(ins.operand), stack.back(), error)) {
+                return false;
+            }
+            break;
+
+        case CallBuiltinOp: {
+            // arguments are the top count values, in order
+            args.assign(stack.end() - ins.count, stack.end());
+            stack.resize(stack.size() - ins.count);
+            const Call& call = program.calls[ins.operand];
+            stack.emplace_back();
+            bool builtin = call.proc != nullptr && program.version == env.version();
+            bool called;
+            if (builtin) {
+                called = call.proc(args, stack.back(), error);
+            }
+            else { // not a builtin, or the bindings changed since compile
+                called = env.call(Symbol::fromId(call.symbol), args, stack.back(), error);
+            }
+            if (!called) {
+                return false;
+            }
+            if (call.symbol == DrawId && sink != nullptr && (builtin || env.getProcedure(Symbol::fromId(DrawId)) != nullptr)) {
+                sink->draw(args.data(), args.size());
+            }
+            break;
+        }
+
+        case JumpIfFalseOp: {
+            const Atom& condition = stack.back();
+            if (condition.type != BooleanType) { // check if condition is a boolean
+                return error.fail(SpecialFormError, "Error: 'if' condition must be a boolean");
+            }
+            bool value = condition.value.bool_value;
+            stack.pop_back();
+            if (!value) {
+                pc = ins.operand - 1;
+            }
+            break;
+        }
+
+        case JumpOp:
+            pc = ins.operand - 1;
+            break;
+
+        case DefineStoreOp:
+            env.define(Symbol::fromId(ins.operand), Expression(stack.back()));
+            break;
+
+        case PopOp:
+            stack.pop_back();
+            break;
+
+        case FailOp:
+            error = program.errors[ins.operand];
+            return false;
+        }
+    }
+
+    result = stack.back();
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+// system includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+#include "ast.hpp"
+#include "environment.hpp"
+#include "eval_error.hpp"
+#include "geometry_sink.hpp"
+
+// operations of the stack machine
+enum OpCode : std::uint8_t {
+    PushConstOp,     // push constants[operand]
+    LoadSymbolOp,    // push the value bound to symbol operand
+    CallBuiltinOp,   // pop count arguments, push the result of calls[operand]
+    JumpIfFalseOp,   // pop a boolean, jump to operand if it is false
+    JumpOp,          // jump to operand
+    DefineStoreOp,   // bind symbol operand to the top of the stack, leaving it there
+    PopOp,           // drop the top of the stack
+    FailOp           // stop with errors[operand]
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t operand;
+    std::uint32_t count;
+};
+
+// a procedure call site, proc is the builtin symbol resolved to when
+// compiled, or its variant without type checks, nullptr if it is bound
+// to some other procedure
+struct Call {
+    SymbolId symbol;
+    Procedure proc;
+};
+
+// A Program is the compiled form of one AST, its result is the single
+// value left on the stack
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<Atom> constants;
+    std::vector<EvalError> errors;
+    std::vector<Call> calls;
+    std::uint64_t version = 0; // Environment::version() the calls were resolved at
+
+    void clear();
+};
+
+// compile the subtree of ast at root into program. The errors the tree
+// walker raises are compiled to FailOp at the same point of evaluation,
+// so both report the same error for the same input
+void compile(const Ast& ast, std::uint32_t root, const Environment& env, Program& program);
+
+// VirtualMachine runs Programs on a value stack, the stack storage is
+// kept between runs. Calls of the builtin draw pass their graphics to
+// sink, they are dropped if it is nullptr
+class VirtualMachine {
+public:
+    explicit VirtualMachine(GeometrySink* sink = nullptr);
+
+    Expression run(const Program& program, Environment& env);
+
+    // run without throwing, the value is stored in result or the error
+    // that stopped the program in error
+    bool run(const Program& program, Environment& env, Atom& result, EvalError& error);
+
+private:
+    GeometrySink* sink;
+    std::vector<Atom> stack;
+    std::vector<Atom> args;
+};
+
+#endif
@@ -16,3 +16,23 @@ CanvasWidget::CanvasWidget(QWidget* parent) : QWidget(parent), scene(new QGraphi
 void CanvasWidget::addGraphic(QGraphicsItem* item) { 
     scene->addItem(item);
 }
+
+void CanvasWidget::addGraphics(const QVector<QGraphicsItem*>& items) {
+    if (items.isEmpty()) {
+        return;
+    }
+
+    // the scene index is left on: it already defers indexing added items
+    // until the next query or paint, and turning it off and on again only
+    // rebuilds it from scratch
+    view->setUpdatesEnabled(false);
+    for (QGraphicsItem* item : items) {
+        scene->addItem(item);
+    }
+    view->setUpdatesEnabled(true);
+    view->viewport()->update();
+}
+
+void CanvasWidget::setSceneIndexing(bool enabled) {
+    scene->setItemIndexMethod(enabled ? QGraphicsScene::BspTreeIndex : QGraphicsScene::NoIndex);
+}
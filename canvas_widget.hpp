@@ -5,6 +5,7 @@
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QVBoxLayout>
+#include <QVector>
 
 class CanvasWidget: public QWidget{
   Q_OBJECT
@@ -17,6 +18,14 @@ public:
   // object derived from QGraphicsItem to draw
   void addGraphic(QGraphicsItem * item);
 
+  // add many items at once, the view is repainted once for all of them
+  void addGraphics(const QVector<QGraphicsItem*>& items);
+
+  // use the scene's own BSP index, on by default. Off, the scene finds
+  // and paints items by testing the bounds of every one, which is cheap
+  // once batches are display lists
+  void setSceneIndexing(bool enabled);
+
 private:
 
   QGraphicsScene * scene;
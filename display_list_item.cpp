@@ -0,0 +1,350 @@
+#include "display_list_item.hpp"
+
+#include <QPainterPath>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cmath>
+
+// pens of the items drawn one by one: outlines are 3 wide, a point is a
+// filled circle of diameter 10 with a pen 1 wide
+static const qreal PenWidth = 3;
+static const qreal PointWidth = 11;
+
+// half the pen width, how far a primitive paints past its geometry
+static const qreal Margin = PenWidth / 2;
+static const qreal PointMargin = PointWidth / 2;
+
+// an entry is the kind of a primitive above its position in the buffer,
+// a run the kind above the number of primitives in it
+static const int KindShift = 29;
+static const quint32 PositionMask = (1u << KindShift) - 1;
+
+// true if the rects meet, unlike QRectF::intersects also for lines and points
+static bool overlaps(const QRectF& a, const QRectF& b) {
+    return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+static QRectF grown(const QRectF& rect, qreal margin) {
+    return rect.adjusted(-margin, -margin, margin, margin);
+}
+
+// a pen of width, or the cosmetic pen 1 pixel wide once it would be
+// thinner than a pixel, which the raster engine draws much faster
+static QPen pen_of(qreal width, qreal scale, Qt::PenCapStyle cap = Qt::SquareCap) {
+    QPen pen(Qt::black, width * scale < 1 ? 0 : width);
+    pen.setCapStyle(cap);
+    return pen;
+}
+
+// the pie of an arc, as QGraphicsEllipseItem paints it
+static QPainterPath pie_of(const QRectF& rect, int start, int span) {
+    QPainterPath path;
+    path.moveTo(rect.center());
+    path.arcTo(rect, start / 16.0, span / 16.0);
+    path.closeSubpath();
+    return path;
+}
+
+// count a primitive of kind added last, in the last run if it is of kind
+void DisplayListItem::Buffers::extend(Kind kind) {
+    quint32 run = static_cast<quint32>(kind) << KindShift;
+    if (!runs.isEmpty() && (runs.back() & ~PositionMask) == run && (runs.back() & PositionMask) != PositionMask) {
+        ++runs.back();
+    }
+    else {
+        runs.push_back(run | 1u);
+    }
+}
+
+// empty the buffers, keeping their capacity
+void DisplayListItem::Buffers::clear() {
+    points.resize(0);
+    lines.resize(0);
+    arcs.resize(0);
+    arcStarts.resize(0);
+    arcSpans.resize(0);
+    rects.resize(0);
+    fills.resize(0);
+    fillColors.resize(0);
+    ellipses.resize(0);
+    runs.resize(0);
+}
+
+DisplayListItem::DisplayListItem(QGraphicsItem* parent) : QGraphicsItem(parent), index(CellSize) {
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption); // for option->exposedRect
+}
+
+// index the primitive at position of the buffer of kind, painted within rect
+void DisplayListItem::include(Kind kind, int position, const QRectF& rect) {
+    prepareGeometryChange();
+    bounds = entries.isEmpty() ? rect : bounds.united(rect);
+    index.insert(rect);
+    entries.push_back(static_cast<quint32>(kind) << KindShift | static_cast<quint32>(position));
+    all.extend(kind);
+}
+
+void DisplayListItem::addPoint(const QPointF& center) {
+    all.points.push_back(center);
+    include(PointKind, all.points.size() - 1, grown(QRectF(center, center), PointMargin));
+}
+
+void DisplayListItem::addLine(const QLineF& line) {
+    all.lines.push_back(line);
+    include(LineKind, all.lines.size() - 1, grown(QRectF(line.p1(), line.p2()).normalized(), Margin));
+}
+
+void DisplayListItem::addArc(const QRectF& rect, int start, int span) {
+    all.arcs.push_back(rect);
+    all.arcStarts.push_back(start);
+    all.arcSpans.push_back(span);
+    include(ArcKind, all.arcs.size() - 1, grown(rect.normalized(), Margin));
+}
+
+void DisplayListItem::addRect(const QRectF& rect) {
+    all.rects.push_back(rect);
+    include(RectKind, all.rects.size() - 1, grown(rect.normalized(), Margin));
+}
+
+void DisplayListItem::addFillRect(const QRectF& rect, QRgb color) {
+    all.fills.push_back(rect);
+    all.fillColors.push_back(color);
+    include(FillKind, all.fills.size() - 1, rect.normalized()); // no pen
+}
+
+void DisplayListItem::addEllipse(const QRectF& rect) {
+    all.ellipses.push_back(rect);
+    include(EllipseKind, all.ellipses.size() - 1, grown(rect.normalized(), Margin));
+}
+
+int DisplayListItem::size() const {
+    return entries.size();
+}
+
+QRectF DisplayListItem::boundingRect() const {
+    return bounds;
+}
+
+// true if point is on the primitive of entry
+bool DisplayListItem::hits(quint32 entry, const QPointF& point) const {
+    int i = static_cast<int>(entry & PositionMask);
+    switch (entry >> KindShift) {
+    case PointKind:
+        return QLineF(all.points[i], point).length() <= PointMargin;
+    case LineKind: {
+        // distance from point to the segment
+        const QLineF& line = all.lines[i];
+        QPointF d = line.p2() - line.p1();
+        qreal length = QPointF::dotProduct(d, d);
+        qreal t = length == 0 ? 0 : QPointF::dotProduct(point - line.p1(), d) / length;
+        t = std::max<qreal>(0, std::min<qreal>(1, t));
+        return QLineF(line.p1() + t * d, point).length() <= Margin;
+    }
+    case ArcKind:
+        return pie_of(all.arcs[i], all.arcStarts[i], all.arcSpans[i]).contains(point);
+    case RectKind:
+        return grown(all.rects[i].normalized(), Margin).contains(point);
+    case FillKind:
+        return all.fills[i].normalized().contains(point);
+    case EllipseKind: {
+        QRectF outer = grown(all.ellipses[i].normalized(), Margin);
+        qreal x = (point.x() - outer.center().x()) / (outer.width() / 2);
+        qreal y = (point.y() - outer.center().y()) / (outer.height() / 2);
+        return x * x + y * y <= 1;
+    }
+    }
+    return false;
+}
+
+bool DisplayListItem::contains(const QPointF& point) const {
+    if (!overlaps(bounds, QRectF(point, point))) {
+        return false;
+    }
+    QVector<quint32> ids;
+    index.query(QRectF(point, point), ids);
+    for (quint32 id : ids) {
+        if (hits(entries[id], point)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the area of the primitive of entry, the points hits is true for
+QPainterPath DisplayListItem::shapeOf(quint32 entry) const {
+    int i = static_cast<int>(entry & PositionMask);
+    QPainterPath path;
+    switch (entry >> KindShift) {
+    case PointKind:
+        path.addEllipse(all.points[i], PointMargin, PointMargin);
+        break;
+    case LineKind: {
+        QPainterPath line;
+        line.moveTo(all.lines[i].p1());
+        line.lineTo(all.lines[i].p2());
+        QPainterPathStroker stroker;
+        stroker.setWidth(PenWidth);
+        stroker.setCapStyle(Qt::RoundCap);
+        path = stroker.createStroke(line);
+        break;
+    }
+    case ArcKind:
+        path = pie_of(all.arcs[i], all.arcStarts[i], all.arcSpans[i]);
+        break;
+    case RectKind:
+        path.addRect(grown(all.rects[i].normalized(), Margin));
+        break;
+    case FillKind:
+        path.addRect(all.fills[i].normalized());
+        break;
+    case EllipseKind:
+        path.addEllipse(grown(all.ellipses[i].normalized(), Margin));
+        break;
+    }
+    return path;
+}
+
+bool DisplayListItem::collidesWithPath(const QPainterPath& path, Qt::ItemSelectionMode mode) const {
+    if (mode == Qt::ContainsItemBoundingRect || mode == Qt::IntersectsItemBoundingRect) {
+        return QGraphicsItem::collidesWithPath(path, mode);
+    }
+    QRectF area = path.boundingRect();
+    if (mode == Qt::ContainsItemShape) { // every primitive is in path
+        if (entries.isEmpty() || !area.contains(bounds)) {
+            return false;
+        }
+        for (quint32 entry : entries) {
+            if (!path.contains(shapeOf(entry))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!overlaps(bounds, area)) {
+        return false;
+    }
+    QVector<quint32> ids;
+    index.query(area, ids);
+    for (quint32 id : ids) {
+        if (path.intersects(shapeOf(entries[id]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// copy the primitives of ids to shown, in the order they were added
+void DisplayListItem::gather(const QVector<quint32>& ids) {
+    shown.clear();
+    for (quint32 id : ids) {
+        int i = static_cast<int>(entries[id] & PositionMask);
+        Kind kind = static_cast<Kind>(entries[id] >> KindShift);
+        shown.extend(kind);
+        switch (kind) {
+        case PointKind:
+            shown.points.push_back(all.points[i]);
+            break;
+        case LineKind:
+            shown.lines.push_back(all.lines[i]);
+            break;
+        case ArcKind:
+            shown.arcs.push_back(all.arcs[i]);
+            shown.arcStarts.push_back(all.arcStarts[i]);
+            shown.arcSpans.push_back(all.arcSpans[i]);
+            break;
+        case RectKind:
+            shown.rects.push_back(all.rects[i]);
+            break;
+        case FillKind:
+            shown.fills.push_back(all.fills[i]);
+            shown.fillColors.push_back(all.fillColors[i]);
+            break;
+        case EllipseKind:
+            shown.ellipses.push_back(all.ellipses[i]);
+            break;
+        }
+    }
+}
+
+void DisplayListItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    qreal scale = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    // when all is exposed the buffers are painted as they are, else the
+    // index finds the primitives meeting the exposed rect
+    if (option->exposedRect.contains(bounds)) {
+        paintBuffers(painter, all, scale);
+        return;
+    }
+    index.query(option->exposedRect, found);
+    gather(found);
+    paintBuffers(painter, shown, scale);
+}
+
+void DisplayListItem::paintBuffers(QPainter* painter, const Buffers& buffers, qreal scale) {
+    painter->save();
+
+    // each run starts where the last run of its kind ended in its buffer
+    int next[EllipseKind + 1] = {};
+    for (quint32 run : buffers.runs) {
+        int kind = static_cast<int>(run >> KindShift);
+        int first = next[kind];
+        int last = first + static_cast<int>(run & PositionMask);
+        next[kind] = last;
+
+        switch (kind) {
+        case FillKind:
+            // a call for each run of one color
+            painter->setPen(Qt::NoPen);
+            while (first < last) {
+                int end = first + 1;
+                while (end < last && buffers.fillColors[end] == buffers.fillColors[first]) {
+                    ++end;
+                }
+                painter->setBrush(QColor(buffers.fillColors[first]));
+                painter->drawRects(buffers.fills.constData() + first, end - first);
+                first = end;
+            }
+            break;
+        case RectKind:
+            painter->setBrush(Qt::NoBrush);
+            painter->setPen(pen_of(PenWidth, scale));
+            painter->drawRects(buffers.rects.constData() + first, last - first);
+            break;
+        case EllipseKind:
+            // QPainter has no call for many ellipses or arcs
+            painter->setBrush(Qt::NoBrush);
+            painter->setPen(pen_of(PenWidth, scale));
+            for (int i = first; i < last; ++i) {
+                painter->drawEllipse(buffers.ellipses[i]);
+            }
+            break;
+        case ArcKind:
+            painter->setBrush(Qt::NoBrush);
+            painter->setPen(pen_of(PenWidth, scale));
+            for (int i = first; i < last; ++i) {
+                if (buffers.arcSpans[i] != 0 && buffers.arcSpans[i] % (360 * 16) == 0) { // a full turn has no pie edges
+                    painter->drawEllipse(buffers.arcs[i]);
+                }
+                else {
+                    painter->drawPie(buffers.arcs[i], buffers.arcStarts[i], buffers.arcSpans[i]);
+                }
+            }
+            painter->setPen(pen_of(PenWidth, scale, Qt::FlatCap));
+            for (int i = first; i < last; ++i) {
+                painter->drawArc(buffers.arcs[i], buffers.arcStarts[i], buffers.arcSpans[i]);
+            }
+            break;
+        case LineKind:
+            painter->setPen(pen_of(PenWidth, scale));
+            painter->drawLines(buffers.lines.constData() + first, last - first);
+            break;
+        case PointKind:
+            // a point is a dot of a pen as wide as the disc
+            painter->setPen(pen_of(PointWidth, scale, Qt::RoundCap));
+            painter->drawPoints(buffers.points.constData() + first, last - first);
+            break;
+        }
+    }
+
+    painter->restore();
+}
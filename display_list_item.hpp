@@ -0,0 +1,86 @@
+#ifndef DISPLAY_LIST_ITEM_HPP
+#define DISPLAY_LIST_ITEM_HPP
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QPainterPath>
+#include <QRgb>
+#include <QVector>
+
+#include "spatial_index.hpp"
+
+// A single item holding many primitives, in place of an item for each.
+// The primitives are kept in one buffer per kind and painted in the order
+// they were added, with a call for each run of primitives of one kind and
+// style, only those a grid index finds meeting the exposed rect. They look
+// the same as the items qt_interpreter makes for each graphic
+class DisplayListItem: public QGraphicsItem{
+
+public:
+
+  DisplayListItem(QGraphicsItem *parent = nullptr);
+
+  // a black disc of the size of a point item, centered on center
+  void addPoint(const QPointF& center);
+  void addLine(const QLineF& line);
+  // start and span in 1/16 of a degree, as QPainter::drawArc takes them
+  void addArc(const QRectF& rect, int start, int span);
+  void addRect(const QRectF& rect);
+  void addFillRect(const QRectF& rect, QRgb color);
+  void addEllipse(const QRectF& rect);
+
+  // number of primitives held
+  int size() const;
+
+  QRectF boundingRect() const override;
+
+  // true if point is on one of the primitives, as it would be on their items
+  bool contains(const QPointF& point) const override;
+
+  // true if path meets (or contains) the primitives, the shapes contains
+  // tests, found through the index rather than from a shape of them all
+  bool collidesWithPath(const QPainterPath& path, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const override;
+
+  void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+  enum Kind { PointKind, LineKind, ArcKind, RectKind, FillKind, EllipseKind };
+
+  // a buffer for each kind of primitive, arcs and fill rects in several,
+  // and the runs of one kind in the order they were added
+  struct Buffers {
+    QVector<QPointF> points;
+    QVector<QLineF> lines;
+    QVector<QRectF> arcs;
+    QVector<int> arcStarts;
+    QVector<int> arcSpans;
+    QVector<QRectF> rects;
+    QVector<QRectF> fills;
+    QVector<QRgb> fillColors;
+    QVector<QRectF> ellipses;
+    QVector<quint32> runs;
+    void extend(Kind kind);
+    void clear();
+  };
+  Buffers all;
+  QRectF bounds; // of all primitives, pens included
+
+  // the primitives by their id in index, as their kind and position in
+  // its buffer
+  static const int CellSize = 32;
+  GridIndex index;
+  QVector<quint32> entries;
+
+  // the primitives being painted when not all are exposed
+  Buffers shown;
+  QVector<quint32> found;
+
+  void include(Kind kind, int position, const QRectF& rect);
+  bool hits(quint32 entry, const QPointF& point) const;
+  QPainterPath shapeOf(quint32 entry) const;
+  void gather(const QVector<quint32>& ids);
+  static void paintBuffers(QPainter* painter, const Buffers& buffers, qreal scale);
+};
+
+
+#endif
@@ -1,422 +1,720 @@
 #include "environment.hpp"
 #include "interpreter_semantic_error.hpp"
+#include "list_kernels.hpp"
 #include <cmath> 
+#include <limits>
 #include <iostream>
+#include <algorithm>
 // Example: Using function pointers
 
 
-Environment::Environment() {
+Environment::Environment() : builtins(builtinTable()) {
     this->reset();
 }
 
+// forget every define, the keywords are bound by the builtin table again
 void Environment::reset() {
+    ++bindings; // resolved calls must look up their procedure again
     envmap.clear();
+    overridden = 0;
+}
+
+// the bindings of the keywords every Environment starts with, built on
+// first use and shared by all of them
+const EnvResult* Environment::builtinTable() {
+    struct Table {
+        EnvResult slots[KeywordCount];
+
+        Table() {
+            //pi implementation
+            Atom pi_atom;
+            pi_atom.type = NumberType;
+            pi_atom.value.num_value = std::atan2(0, -1);
+            slots[PiId] = EnvResult(ExpressionType, pi_atom);
+
+            // Arithmetic operators
+            slots[AddId] = EnvResult(&Environment::add);
+            slots[SubtractId] = EnvResult(&Environment::subtract);
+            slots[MultiplyId] = EnvResult(&Environment::multiply);
+            slots[DivideId] = EnvResult(&Environment::divide);
+
+            // Mathematical functions
+            slots[SqrtId] = EnvResult(&Environment::sqrt);
+            slots[Log2Id] = EnvResult(&Environment::log2);
+
+            // Comparison operators
+            slots[LessId] = EnvResult(&Environment::less_than);
+            slots[LessEqualId] = EnvResult(&Environment::less_than_equal);
+            slots[GreaterId] = EnvResult(&Environment::greater_than);
+            slots[GreaterEqualId] = EnvResult(&Environment::greater_than_equal);
+            slots[EqualId] = EnvResult(&Environment::equal_to);
+
+            // Logical operators
+            slots[AndId] = EnvResult(&Environment::logical_and);
+            slots[OrId] = EnvResult(&Environment::logical_or);
+            slots[NotId] = EnvResult(&Environment::logical_not);
+
+            // trig functions
+            slots[SinId] = EnvResult(&Environment::sin_func);
+            slots[CosId] = EnvResult(&Environment::cos_func);
+            slots[ArctanId] = EnvResult(&Environment::arctan);
+
+            // lists
+            slots[RangeId] = EnvResult(&Environment::range);
+            slots[LinspaceId] = EnvResult(&Environment::linspace);
+
+            // graphics
+            slots[PointId] = EnvResult(&Environment::point);
+            slots[LineId] = EnvResult(&Environment::line);
+            slots[ArcId] = EnvResult(&Environment::arc);
+            slots[DrawId] = EnvResult(&Environment::draw);
+            slots[RectId] = EnvResult(&Environment::rect);
+            slots[FillRectId] = EnvResult(&Environment::fill_rect);
+            slots[EllipseId] = EnvResult(&Environment::ellipse);
+
+            // the stamp of a builtin binding is its id, defines stamp above KeywordCount
+            for (SymbolId id = 0; id < KeywordCount; ++id) {
+                if (slots[id].type != UnboundType) {
+                    slots[id].stamp = id;
+                }
+            }
+        }
+    };
+
+    static const Table table; // initialized once, also when first used by several threads
+    return table.slots;
+}
+
+// largest list range and linspace make
+static const std::size_t MaxListSize = std::size_t(1) << 28;
+
+// store value as the result of a builtin
+static bool succeed(Atom& result, const Expression& value) {
+    result = value.head;
+    return true;
+}
 
-    //pi implementation
-    Atom pi_atom;
-    pi_atom.type = NumberType;
-    pi_atom.value.num_value = std::atan2(0, -1);
-    envmap["pi"] = EnvResult(ExpressionType, pi_atom);
-
-    // Arithmetic operators
-    envmap["+"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::add(args); // calls add with args
-        });
-    envmap["-"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::subtract(args);
-        });
-    envmap["*"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::multiply(args);
-        });
-    envmap["/"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::divide(args);
-        });
-
-    // Mathematical functions
-    envmap["sqrt"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::sqrt(args);
-        });
-    envmap["log2"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::log2(args);
-        });
-
-    // Comparison operators
-    envmap["<"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::less_than(args);
-        });
-    envmap["<="] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::less_than_equal(args);
-        });
-    envmap[">"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::greater_than(args);
-        });
-    envmap[">="] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::greater_than_equal(args);
-        });
-    envmap["=="] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::equal_to(args);
-        });
-
-    // Logical operators
-    envmap["and"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::logical_and(args);
-        });
-    envmap["or"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::logical_or(args);
-        });
-    envmap["not"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::logical_not(args);
-        });
-
-    // trig functions
-    envmap["sin"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::sin_func(args);
-        });
-    envmap["cos"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::cos_func(args);
-        });
-    envmap["arctan"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::arctan(args);
-        });
-
-    // graphics
-    envmap["point"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::point(args);
-        });
-
-    envmap["line"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::line(args);
-        });
-
-    envmap["arc"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::arc(args);
-        });
-
-    envmap["draw"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::draw(args);
-        });
-
-    envmap["rect"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::rect(args); 
-        });
-
-    envmap["fill_rect"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::fill_rect(args);
-        });
-    envmap["ellipse"] = EnvResult(ProcedureType, [](Environment& env, const std::vector<Atom>& args) {
-        return Environment::ellipse(args);
-        });
-    
-
-}
-
-Expression Environment::add(const std::vector<Atom>& args) {
-    // check all aruments are numbers, while adding
-    double result = 0;
+// true if any argument is a list
+static bool has_list(const std::vector<Atom>& args) {
     for (const auto& a : args) {
-        if (a.type != NumberType) {
-            throw InterpreterSemanticError("Error in call to add, argument not a number");
+        if (a.type == ListType) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// size of the lists in args, which must all have the same size, else the
+// error is different. Numbers are broadcast to that size, other arguments
+// fail with not_number
+static bool list_size(const std::vector<Atom>& args, const char* different, const char* not_number, std::size_t& size, EvalError& error) {
+    size = 0;
+    bool sized = false;
+    for (const auto& a : args) {
+        if (a.type == ListType) {
+            if (sized && a.value.list_value.size() != size) {
+                return error.fail(ArgumentError, different);
+            }
+            size = a.value.list_value.size();
+            sized = true;
+        }
+        else if (a.type != NumberType) {
+            return error.fail(ArgumentError, not_number);
+        }
+    }
+    return true;
+}
+
+// the numbers of a list or number argument, scalar is set for a number
+static const double* list_operand(const Atom& a, bool& scalar) {
+    scalar = (a.type == NumberType);
+    return scalar ? &a.value.num_value : a.value.list_value.data();
+}
+
+// args[0] op args[1] op ... element-wise, at least one argument is a list
+static bool list_fold(ListOp op, const std::vector<Atom>& args, std::size_t size, Atom& result) {
+    double* out;
+    result = make_list(size, out);
+
+    bool scalar;
+    const double* first = list_operand(args[0], scalar);
+    if (scalar) {
+        std::fill(out, out + size, *first);
+    }
+    else {
+        std::copy(first, first + size, out);
+    }
+
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        const double* operand = list_operand(args[i], scalar);
+        list_binary(op, out, false, operand, scalar, out, size);
+    }
+    return true;
+}
+
+// true for the types draw accepts
+static bool is_graphic(Type type) {
+    return type == PointType || type == LineType || type == ArcType || type == RectType || type == FillRectType || type == EllipseType;
+}
+
+// the single list argument of a one argument function applied element-wise
+static const List& list_argument(const std::vector<Atom>& args) {
+    return args[0].value.list_value;
+}
+
+// The builtins without their type checks. Each is what its builtin does
+// once the number and types of the arguments are checked, for calls whose
+// argument types are proved before eval. Checks of values, as for
+// division by zero, are still made
+
+static bool add_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    double sum = 0;
+    for (const auto& a : args) {
+        sum += a.value.num_value;
+    }
+    return succeed(result, Expression(sum));
+}
+
+static bool subtract_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    if (args.size() == 1) {
+        return succeed(result, Expression(-args[0].value.num_value));
+    }
+    return succeed(result, Expression(args[0].value.num_value - args[1].value.num_value));
+}
+
+static bool multiply_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    double product = 1;
+    for (const auto& a : args) {
+        product *= a.value.num_value;
+    }
+    return succeed(result, Expression(product));
+}
+
+static bool divide_numbers(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args[1].value.num_value == 0) {
+        return error.fail(ArgumentError, "Error in call to divide: division by zero");
+    }
+    return succeed(result, Expression(args[0].value.num_value / args[1].value.num_value));
+}
+
+static bool sqrt_number(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args[0].value.num_value < 0) {
+        return error.fail(ArgumentError, "Error in call to sqrt, invalid argument");
+    }
+    return succeed(result, Expression(std::sqrt(args[0].value.num_value)));
+}
+
+static bool log2_number(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args[0].value.num_value <= 0) {
+        return error.fail(ArgumentError, "Error in call to log2, invalid argument");
+    }
+    return succeed(result, Expression(std::log2(args[0].value.num_value)));
+}
+
+static bool less_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(args[0].value.num_value < args[1].value.num_value));
+}
+
+static bool less_equal_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(args[0].value.num_value <= args[1].value.num_value));
+}
+
+static bool greater_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(args[0].value.num_value > args[1].value.num_value));
+}
+
+static bool greater_equal_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(args[0].value.num_value >= args[1].value.num_value));
+}
+
+static bool equal_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(fabs(args[0].value.num_value - args[1].value.num_value) < std::numeric_limits<double>::epsilon()));
+}
+
+static bool and_booleans(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    for (const auto& a : args) {
+        if (!a.value.bool_value) {
+            return succeed(result, Expression(false));
+        }
+    }
+    return succeed(result, Expression(true));
+}
+
+static bool or_booleans(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    for (const auto& a : args) {
+        if (a.value.bool_value) {
+            return succeed(result, Expression(true));
+        }
+    }
+    return succeed(result, Expression(false));
+}
+
+static bool not_boolean(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(!args[0].value.bool_value));
+}
+
+static bool sin_number(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(sin(args[0].value.num_value)));
+}
+
+static bool cos_number(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(cos(args[0].value.num_value)));
+}
+
+static bool arctan_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(atan2(args[0].value.num_value, args[1].value.num_value)));
+}
+
+static bool point_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    // creating the PointType with  x and y coordinates
+    Expression point(std::make_tuple(args[0].value.num_value, args[1].value.num_value));
+    point.head.type = PointType; // make the head PointType
+    return succeed(result, point);
+}
+
+static bool line_points(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    std::tuple<double, double> start(args[0].value.point_value.x, args[0].value.point_value.y);
+    std::tuple<double, double> end(args[1].value.point_value.x, args[1].value.point_value.y);
+    return succeed(result, Expression(start, end));
+}
+
+static bool line_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    // line start and end points from the four args
+    std::tuple<double, double> start(args[0].value.num_value, args[1].value.num_value);
+    std::tuple<double, double> end(args[2].value.num_value, args[3].value.num_value);
+    return succeed(result, Expression(start, end));
+}
+
+static bool arc_points(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    std::tuple<double, double> center(args[0].value.point_value.x, args[0].value.point_value.y);
+    std::tuple<double, double> start(args[1].value.point_value.x, args[1].value.point_value.y);
+    return succeed(result, Expression(center, start, args[2].value.num_value));
+}
+
+static bool arc_numbers(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    // center, start, and angle using the five args
+    std::tuple<double, double> center(args[0].value.num_value, args[1].value.num_value);
+    std::tuple<double, double> start(args[2].value.num_value, args[3].value.num_value);
+    return succeed(result, Expression(center, start, args[4].value.num_value));
+}
+
+static bool rect_points(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    return succeed(result, Expression(args[0].value.point_value, args[1].value.point_value));
+}
+
+static bool fill_rect_color(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    double r = args[1].value.num_value;
+    double g = args[2].value.num_value;
+    double b = args[3].value.num_value;
+
+    // color range must be in range 0-255
+    if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) {
+        return error.fail(ArgumentError, "Color values must be in the range [0, 255]");
+    }
+    return succeed(result, Expression(args[0].value.rect_value, r, g, b));
+}
+
+static bool ellipse_rect(const std::vector<Atom>& args, Atom& result, EvalError&) {
+    Expression ellipseExp;
+    ellipseExp.head.type = EllipseType;
+    ellipseExp.head.value.ellipse_value.rect = args[0].value.rect_value; // the only arg is rect
+    return succeed(result, ellipseExp);
+}
+
+bool Environment::add(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (has_list(args)) {
+        std::size_t size;
+        if (!list_size(args, "Error in call to add: lists of different sizes", "Error in call to add, argument not a number", size, error)) {
+            return false;
         }
-        result += a.value.num_value;
+        return list_fold(ListAdd, args, size, result);
     }
 
-    return Expression(result);
+    // check all aruments are numbers
+    for (const auto& a : args) {
+        if (a.type != NumberType) {
+            return error.fail(ArgumentError, "Error in call to add, argument not a number");
+        }
+    }
+    return add_numbers(args, result, error);
 };
 
 // TODO: add further functions necessary to implement the requirements of Project 2.
 
-Expression Environment::subtract(const std::vector<Atom>& args) {
+bool Environment::subtract(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if ((args.size() == 1 || args.size() == 2) && has_list(args)) {
+        std::size_t size;
+        if (!list_size(args, "Error in call to subtract: lists of different sizes", args.size() == 1 ?
+            "Error in call to subtract: argument not a number" : "Error in call to subtract: arguments not numbers", size, error)) {
+            return false;
+        }
+        if (args.size() == 1) { // negate as 0 - list
+            double zero = 0;
+            double* out;
+            result = make_list(size, out);
+            list_binary(ListSubtract, &zero, true, list_argument(args).data(), false, out, size);
+            return true;
+        }
+        return list_fold(ListSubtract, args, size, result);
+    }
+
     if (args.size() == 1) {
         if (args[0].type != NumberType) {
-            throw InterpreterSemanticError("Error in call to subtract: argument not a number");
+            return error.fail(ArgumentError, "Error in call to subtract: argument not a number");
         }
-        return Expression(-args[0].value.num_value);
+        return subtract_numbers(args, result, error);
     }
     if (args.size() == 2) {
         if (args[0].type != NumberType || args[1].type != NumberType) {
-            throw InterpreterSemanticError("Error in call to subtract: arguments not numbers");
+            return error.fail(ArgumentError, "Error in call to subtract: arguments not numbers");
         }
-        return Expression(args[0].value.num_value - args[1].value.num_value);
+        return subtract_numbers(args, result, error);
     }
-    throw InterpreterSemanticError("Error in call to subtract: wrong number of arguments");
+    return error.fail(ArgumentError, "Error in call to subtract: wrong number of arguments");
 }
 
 
-Expression Environment::multiply(const std::vector<Atom>& args) {
-    double result = 1;
+bool Environment::multiply(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (has_list(args)) {
+        std::size_t size;
+        if (!list_size(args, "Error in call to multiply: lists of different sizes", "Error in call to multiply: argument not a number", size, error)) {
+            return false;
+        }
+        return list_fold(ListMultiply, args, size, result);
+    }
+
     for (const auto& a : args) {
         if (a.type != NumberType) {
-            throw InterpreterSemanticError("Error in call to multiply: argument not a number");
+            return error.fail(ArgumentError, "Error in call to multiply: argument not a number");
         }
-        result *= a.value.num_value;
     }
-    return Expression(result);
+    return multiply_numbers(args, result, error);
 }
 
-Expression Environment::divide(const std::vector<Atom>& args) {
+bool Environment::divide(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2) {
-        throw InterpreterSemanticError("Error in call to divide: wrong number of arguments");
+        return error.fail(ArgumentError, "Error in call to divide: wrong number of arguments");
     }
-    if (args[0].type != NumberType || args[1].type != NumberType) {
-        throw InterpreterSemanticError("Error in call to divide: argument not a number");
+    if (has_list(args)) {
+        std::size_t size;
+        if (!list_size(args, "Error in call to divide: lists of different sizes", "Error in call to divide: argument not a number", size, error)) {
+            return false;
+        }
+        bool scalar;
+        const double* divisor = list_operand(args[1], scalar);
+        if (std::find(divisor, divisor + (scalar ? 1 : size), 0.0) != divisor + (scalar ? 1 : size)) {
+            return error.fail(ArgumentError, "Error in call to divide: division by zero");
+        }
+        return list_fold(ListDivide, args, size, result);
     }
-    if (args[1].value.num_value == 0) {
-        throw InterpreterSemanticError("Error in call to divide: division by zero");
+    if (args[0].type != NumberType || args[1].type != NumberType) {
+        return error.fail(ArgumentError, "Error in call to divide: argument not a number");
     }
-    return Expression(args[0].value.num_value / args[1].value.num_value);
+    return divide_numbers(args, result, error);
 }
 
 
-Expression Environment::sqrt(const std::vector<Atom>& args) {
-    if (args.size() != 1 || args[0].type != NumberType || args[0].value.num_value < 0) {
-        throw InterpreterSemanticError("Error in call to sqrt, invalid argument");
+bool Environment::sqrt(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args.size() == 1 && args[0].type == ListType) {
+        const List& list = list_argument(args);
+        const double* end = list.data() + list.size();
+        if (std::find_if(list.data(), end, [](double x) { return x < 0; }) != end) {
+            return error.fail(ArgumentError, "Error in call to sqrt, invalid argument");
+        }
+        double* out;
+        result = make_list(list.size(), out);
+        list_sqrt(list.data(), out, list.size());
+        return true;
+    }
+    if (args.size() != 1 || args[0].type != NumberType) {
+        return error.fail(ArgumentError, "Error in call to sqrt, invalid argument");
     }
-    return Expression(std::sqrt(args[0].value.num_value));
+    return sqrt_number(args, result, error);
 }
 
-Expression Environment::log2(const std::vector<Atom>& args) {
-    if (args.size() != 1 || args[0].type != NumberType || args[0].value.num_value <= 0) {
-        throw InterpreterSemanticError("Error in call to log2, invalid argument");
+bool Environment::log2(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args.size() != 1 || args[0].type != NumberType) {
+        return error.fail(ArgumentError, "Error in call to log2, invalid argument");
     }
-    return Expression(std::log2(args[0].value.num_value));
+    return log2_number(args, result, error);
 }
 
-Expression Environment::less_than(const std::vector<Atom>& args) {
+bool Environment::less_than(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType) {
-        throw InterpreterSemanticError("Error in call to less_than, invalid arguments");
+        return error.fail(ArgumentError, "Error in call to less_than, invalid arguments");
     }
-    return Expression(args[0].value.num_value < args[1].value.num_value);
+    return less_numbers(args, result, error);
 }
 
 
-Expression Environment::less_than_equal(const std::vector<Atom>& args) {
+bool Environment::less_than_equal(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType) {
-        throw InterpreterSemanticError("Error in call to less_than_equal, invalid arguments");
+        return error.fail(ArgumentError, "Error in call to less_than_equal, invalid arguments");
     }
-    return Expression(args[0].value.num_value <= args[1].value.num_value);
+    return less_equal_numbers(args, result, error);
 }
 
-Expression Environment::greater_than(const std::vector<Atom>& args) {
+bool Environment::greater_than(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2) {
-        throw InterpreterSemanticError("Error in call to greater_than: wrong number of arguments");
+        return error.fail(ArgumentError, "Error in call to greater_than: wrong number of arguments");
     }
     if (args[0].type != NumberType || args[1].type != NumberType) {
-        throw InterpreterSemanticError("Error in call to greater_than: argument not a number");
+        return error.fail(ArgumentError, "Error in call to greater_than: argument not a number");
     }
-    return Expression(args[0].value.num_value > args[1].value.num_value);
+    return greater_numbers(args, result, error);
 }
 
-Expression Environment::greater_than_equal(const std::vector<Atom>& args) {
+bool Environment::greater_than_equal(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType) {
-        throw InterpreterSemanticError("Error in call to greater_than_equal: wrong number of arguments or invalid type");
+        return error.fail(ArgumentError, "Error in call to greater_than_equal: wrong number of arguments or invalid type");
     }
-    return Expression(args[0].value.num_value >= args[1].value.num_value);
+    return greater_equal_numbers(args, result, error);
 }
 
-Expression Environment::equal_to(const std::vector<Atom>& args) {
+bool Environment::equal_to(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2) {
-        throw InterpreterSemanticError("Error in call to equal_to: wrong number of arguments");
+        return error.fail(ArgumentError, "Error in call to equal_to: wrong number of arguments");
     }
     if (args[0].type != NumberType || args[1].type != NumberType) {
-        throw InterpreterSemanticError("Error in call to equal_to: argument not a number");
+        return error.fail(ArgumentError, "Error in call to equal_to: argument not a number");
     }
-    return Expression(fabs(args[0].value.num_value - args[1].value.num_value) < std::numeric_limits<double>::epsilon());
+    return equal_numbers(args, result, error);
 }
 
-Expression Environment::logical_and(const std::vector<Atom>& args) {
+bool Environment::logical_and(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     for (const auto& a : args) {
         if (a.type != BooleanType) {
-            throw InterpreterSemanticError("Error in call to and: argument not a boolean");
+            return error.fail(ArgumentError, "Error in call to and: argument not a boolean");
         }
         if (!a.value.bool_value) {
-            return Expression(false);
+            return succeed(result, Expression(false));
         }
     }
-    return Expression(true);
+    return succeed(result, Expression(true));
 }
 
-Expression Environment::logical_or(const std::vector<Atom>& args) {
+bool Environment::logical_or(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     for (const auto& a : args) {
         if (a.type != BooleanType) {
-            throw InterpreterSemanticError("Error in call to or: argument not a boolean");
+            return error.fail(ArgumentError, "Error in call to or: argument not a boolean");
         }
         if (a.value.bool_value) {
-            return Expression(true);
+            return succeed(result, Expression(true));
         }
     }
-    return Expression(false);
+    return succeed(result, Expression(false));
 }
 
-Expression Environment::logical_not(const std::vector<Atom>& args) {
+bool Environment::logical_not(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 1) {
-        throw InterpreterSemanticError("Error in call to not: wrong number of arguments");
+        return error.fail(ArgumentError, "Error in call to not: wrong number of arguments");
     }
     if (args[0].type != BooleanType) {
-        throw InterpreterSemanticError("Error in call to not: argument not a boolean");
+        return error.fail(ArgumentError, "Error in call to not: argument not a boolean");
     }
-    return Expression(!args[0].value.bool_value);
+    return not_boolean(args, result, error);
 }
 
-Expression Environment::sin_func(const std::vector<Atom>& args) {
+bool Environment::sin_func(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 1) {
-        throw InterpreterSemanticError("sin expects one argument");
+        return error.fail(ArgumentError, "sin expects one argument");
     }
-    return Expression(sin(args[0].value.num_value));
+    if (args[0].type == ListType) {
+        const List& list = list_argument(args);
+        double* out;
+        result = make_list(list.size(), out);
+        list_sin(list.data(), out, list.size());
+        return true;
+    }
+    return sin_number(args, result, error);
 }
 
-Expression Environment::cos_func(const std::vector<Atom>& args) {
+bool Environment::cos_func(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 1) {
-        throw InterpreterSemanticError("cos expects one argument");
+        return error.fail(ArgumentError, "cos expects one argument");
+    }
+    if (args[0].type == ListType) {
+        const List& list = list_argument(args);
+        double* out;
+        result = make_list(list.size(), out);
+        list_cos(list.data(), out, list.size());
+        return true;
+    }
+    return cos_number(args, result, error);
+}
+
+// (start stop range) or (start stop step range), the numbers from start
+// up to but not including stop, step apart
+bool Environment::range(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args.size() != 2 && args.size() != 3) {
+        return error.fail(ArgumentError, "Error in call to range: wrong number of arguments");
+    }
+    for (const auto& a : args) {
+        if (a.type != NumberType) {
+            return error.fail(ArgumentError, "Error in call to range: argument not a number");
+        }
+    }
+
+    double start = args[0].value.num_value;
+    double stop = args[1].value.num_value;
+    double step = args.size() == 3 ? args[2].value.num_value : 1;
+    if (step == 0) {
+        return error.fail(ArgumentError, "Error in call to range: step is zero");
+    }
+
+    double count = std::ceil((stop - start) / step);
+    if (!(count < MaxListSize)) {
+        return error.fail(ArgumentError, "Error in call to range: too many elements");
+    }
+    std::size_t size = count > 0 ? static_cast<std::size_t>(count) : 0;
+
+    double* out;
+    result = make_list(size, out);
+    for (std::size_t i = 0; i < size; ++i) {
+        out[i] = start + i * step;
+    }
+    return true;
+}
+
+// (start stop count linspace), count numbers evenly spaced from start to stop
+bool Environment::linspace(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args.size() != 3) {
+        return error.fail(ArgumentError, "Error in call to linspace: wrong number of arguments");
+    }
+    for (const auto& a : args) {
+        if (a.type != NumberType) {
+            return error.fail(ArgumentError, "Error in call to linspace: argument not a number");
+        }
+    }
+
+    double start = args[0].value.num_value;
+    double stop = args[1].value.num_value;
+    double count = args[2].value.num_value;
+    if (count < 1 || count != std::floor(count) || !(count < MaxListSize)) {
+        return error.fail(ArgumentError, "Error in call to linspace: invalid count");
     }
-    return Expression(cos(args[0].value.num_value));
+    std::size_t size = static_cast<std::size_t>(count);
+
+    double* out;
+    result = make_list(size, out);
+    double step = size > 1 ? (stop - start) / (size - 1) : 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        out[i] = start + i * step;
+    }
+    if (size > 1) {
+        out[size - 1] = stop; // exact end point
+    }
+    return true;
 }
 
-Expression Environment::arctan(const std::vector<Atom>& args) {
+bool Environment::arctan(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2) {
-        throw InterpreterSemanticError("arctan expects two arguments");
+        return error.fail(ArgumentError, "arctan expects two arguments");
     }
-    return Expression(atan2(args[0].value.num_value, args[1].value.num_value));
+    return arctan_numbers(args, result, error);
 }
 
-Expression Environment::point(const std::vector<Atom>& args) {
+bool Environment::point(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2) { // takes two Numbers
-        throw InterpreterSemanticError("point expects two arguments");
+        return error.fail(ArgumentError, "point expects two arguments");
     }
 
     if (args[0].type != NumberType || args[1].type != NumberType) { // must be numbers
-        throw InterpreterSemanticError("point arguments must be numbers");
+        return error.fail(ArgumentError, "point arguments must be numbers");
     }
-
-    // creating the PointType with  x and y coordinates
-    Expression point(std::make_tuple(args[0].value.num_value, args[1].value.num_value));
-    point.head.type = PointType; // make the head PointType
-    return point;
+    return point_numbers(args, result, error);
 }
 
 
-Expression Environment::line(const std::vector<Atom>& args) {
+bool Environment::line(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     // outputs made with help of AI
     // if 2 inputs get the coordinates from the PointType atoms
     if (args.size() == 2 && args[0].type == PointType && args[1].type == PointType) {
-        std::tuple<double, double> start(args[0].value.point_value.x, args[0].value.point_value.y);
-        std::tuple<double, double> end(args[1].value.point_value.x, args[1].value.point_value.y);
-        return Expression(start, end);
+        return line_points(args, result, error);
     }
 
     // make sure the arguments are numbers and tthere are 4
     if (args.size() == 4) {
         for (const auto& arg : args) {
             if (arg.type != NumberType) {
-                throw InterpreterSemanticError("line arguments must be numbers");
+                return error.fail(ArgumentError, "line arguments must be numbers");
             }
         }
-        // line start and end points from the four args
-        std::tuple<double, double> start(args[0].value.num_value, args[1].value.num_value);
-        std::tuple<double, double> end(args[2].value.num_value, args[3].value.num_value);
-        return Expression(start, end);
+        return line_numbers(args, result, error);
     }
     else {
-        throw InterpreterSemanticError("line expects either four numbers or two points as arguments");
+        return error.fail(ArgumentError, "line expects either four numbers or two points as arguments");
     }
 }
 
-Expression Environment::arc(const std::vector<Atom>& args) {
+bool Environment::arc(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     // outputs made with help of AI
     // two points and an angle
     if (args.size() == 3 && args[0].type == PointType && args[1].type == PointType && args[2].type == NumberType) {
-        std::tuple<double, double> center(args[0].value.point_value.x, args[0].value.point_value.y);
-        std::tuple<double, double> start(args[1].value.point_value.x, args[1].value.point_value.y);
-        double angle = args[2].value.num_value;
-
-        return Expression(center, start, angle);
+        return arc_points(args, result, error);
     }
     // five NumberType numeric args
     if (args.size() == 5) {
         for (const auto& arg : args) {
             if (arg.type != NumberType) {
-                throw InterpreterSemanticError("arc arguments must be numbers");
+                return error.fail(ArgumentError, "arc arguments must be numbers");
             }
         }
-
-        // center, start, and angle using the five args
-        std::tuple<double, double> center(args[0].value.num_value, args[1].value.num_value);
-        std::tuple<double, double> start(args[2].value.num_value, args[3].value.num_value);
-        double angle = args[4].value.num_value;
-
-        return Expression(center, start, angle);
+        return arc_numbers(args, result, error);
     }
     else {
-        throw InterpreterSemanticError("arc expects either five numbers or two points and an angle");
+        return error.fail(ArgumentError, "arc expects either five numbers or two points and an angle");
     }
 }
 
 
-Expression Environment::draw(const std::vector<Atom>& args) {
-    if (args.size() != 1) {
-        throw InterpreterSemanticError("draw expects one argument");
+// (graphic ... draw) checks that every argument is a graphic and gives
+// the last one. The evaluator passes the graphics of a draw to the
+// interpreter's GeometrySink once it succeeds
+bool Environment::draw(const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    if (args.empty()) {
+        return error.fail(ArgumentError, "draw expects at least one argument");
     }
 
     // check if graphic type, PointType, LineType, ArcType
-    if (args[0].type == PointType || args[0].type == LineType || args[0].type == ArcType || args[0].type == RectType || args[0].type == FillRectType || args[0].type == EllipseType) {
-        return Expression(args[0]);  // Return Expression type
+    for (const auto& arg : args) {
+        if (!is_graphic(arg.type)) {
+            return error.fail(ArgumentError, "draw can only be used with graphical types");
+        }
     }
-    
-    throw InterpreterSemanticError("draw can only be used with graphical types");
-    
+    result = args.back();
+    return true;
 }
 
-Expression Environment::rect(const std::vector<Atom>& args) {
+bool Environment::rect(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 2) { // two arguments
-        throw InterpreterSemanticError("rect expects two arguments: top-left and bottom-right points");
+        return error.fail(ArgumentError, "rect expects two arguments: top-left and bottom-right points");
     }
 
     if (args[0].type != PointType || args[1].type != PointType) { // both args Points have to be points
-        throw InterpreterSemanticError("rect arguments must be points");
+        return error.fail(ArgumentError, "rect arguments must be points");
     }
 
-    // get the two point values
-    Point point1 = args[0].value.point_value;
-    Point point2 = args[1].value.point_value;
-
-    return Expression(point1, point2);
+    return rect_points(args, result, error);
 }
 
-Expression Environment::fill_rect(const std::vector<Atom>& args) {
+bool Environment::fill_rect(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 4 && args.size() != 7) { // args cant be 4 or 7 
-        throw InterpreterSemanticError("fill_rect expects a rect and three color values (r, g, b)");
+        return error.fail(ArgumentError, "fill_rect expects a rect and three color values (r, g, b)");
     }
 
     if (args[0].type != RectType) { // must be a rect type
-        throw InterpreterSemanticError("First argument to fill_rect must be a rectangle");
+        return error.fail(ArgumentError, "First argument to fill_rect must be a rectangle");
     }
 
-    Rectt rect = args[0].value.rect_value; // first arg is rect 
-
-    // rest are color values
-    double r = args[1].value.num_value;
-    double g = args[2].value.num_value;
-    double b = args[3].value.num_value;
-
-    // color range must be in range 0-255
-    if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) {
-        throw InterpreterSemanticError("Color values must be in the range [0, 255]");
-    }
-
-    return Expression(rect, r, g, b);
+    return fill_rect_color(args, result, error); // first arg is rect, rest are color values
 }
-Expression Environment::ellipse(const std::vector<Atom>& args) {
+bool Environment::ellipse(const std::vector<Atom>& args, Atom& result, EvalError& error) {
     if (args.size() != 1 || args[0].type != RectType) { // only arg is a rect
-        throw InterpreterSemanticError("ellipse expects one argument of type rect");
+        return error.fail(ArgumentError, "ellipse expects one argument of type rect");
     }
 
-    Ellipsee ellipse;
-    ellipse.rect = args[0].value.rect_value; // the only arg is rect
-
-
-    Expression ellipseExp;
-    ellipseExp.head.type = EllipseType;
-    ellipseExp.head.value.ellipse_value = ellipse;
-    return ellipseExp;
+    return ellipse_rect(args, result, error);
 }
 
 
@@ -424,57 +722,248 @@ Expression Environment::ellipse(const std::vector<Atom>& args) {
 
 
 
+const EnvResult* Environment::find(const Symbol& sym) const {
+    if (sym.id < KeywordCount && (overridden & (std::uint64_t(1) << sym.id)) == 0) { // keywords are at fixed slots
+        const EnvResult& result = builtins[sym.id];
+        return result.type == UnboundType ? nullptr : &result;
+    }
+    auto it = envmap.find(sym.id);
+    return it == envmap.end() ? nullptr : &it->second;
+}
+
 void Environment::define(const Symbol& sym, const Expression& exp) {
-    envmap[sym] = EnvResult(ExpressionType, exp);
+    const EnvResult* old = find(sym);
+    if (sym.id < KeywordCount || (old != nullptr && old->type == ProcedureType)) {
+        ++bindings; // a procedure binding changes
+    }
+    bind(sym, EnvResult(ExpressionType, exp));
 }
 
 // making a new procedure mapping
 void Environment::define(const Symbol& sym, std::function<Expression(Environment&, const std::vector<Atom>&)> proc) {
-    envmap[sym] = EnvResult(ProcedureType, proc);
+    ++bindings;
+    bind(sym, EnvResult(ProcedureType, proc));
+}
+
+void Environment::bind(const Symbol& sym, const EnvResult& result) {
+    if (sym.id < KeywordCount) { // the builtin table is shared, keep the new binding here
+        overridden |= std::uint64_t(1) << sym.id;
+    }
+    EnvResult& binding = envmap[sym.id];
+    binding = result;
+    binding.stamp = ++stamps;
 }
 
 bool Environment::isDefined(const Symbol& sym) const {
-    return envmap.find(sym) != envmap.end();
+    return find(sym) != nullptr;
 }
 
 
 
 // get a mapping
 Expression Environment::get(const Symbol& sym) const {
-    auto it = envmap.find(sym);
-    if (it == envmap.end()) {
-        throw InterpreterSemanticError("Error: Symbol '" + sym + "' not found");
+    const EnvResult* result = find(sym);
+    if (result != nullptr && result->type == ExpressionType) {
+        return result->exp;  // return expression
+    }
+    Atom value;
+    EvalError error;
+    get(sym, value, error);
+    throw InterpreterSemanticError(error.message());
+}
+
+bool Environment::get(const Symbol& sym, Atom& value, EvalError& error) const {
+    const EnvResult* result = find(sym);
+    if (result == nullptr) {
+        return error.fail(UnboundSymbolError, sym.id);
+    }
+    if (result->type != ExpressionType) {
+        return error.fail(NotExpressionError, sym.id);
+    }
+    value = result->exp.head;
+    return true;
+}
+
+bool Environment::call(const Symbol& sym, const std::vector<Atom>& args, Atom& result, EvalError& error) {
+    const EnvResult* binding = find(sym);
+    if (binding == nullptr) {
+        return error.fail(UnboundSymbolError, sym.id);
+    }
+    if (binding->builtin != nullptr) {
+        return binding->builtin(args, result, error);
     }
-    if (it->second.type == ExpressionType) {
-        return it->second.exp;  // return expression
+    if (binding->type != ProcedureType) {
+        return error.fail(UnknownProcedureError, sym.id);
+    }
+
+    // procedures defined by the host report errors by throwing
+    try {
+        result = binding->proc(*this, args).head;
     }
-    throw InterpreterSemanticError("Error: Symbol '" + sym + "' is not an expression");
+    catch (const InterpreterSemanticError& err) {
+        return error.fail(ArgumentError, std::string(err.what()));
+    }
+    return true;
 }
 
 
 bool Environment::isProcedure(const Symbol& sym) const {
-    auto it = envmap.find(sym);
-    return it != envmap.end() && it->second.type == ProcedureType;
+    const EnvResult* result = find(sym);
+    return result != nullptr && result->type == ProcedureType;
 }
 EnvResult Environment::getResult(const Symbol& sym) const {
-    auto it = envmap.find(sym);
-    if (it == envmap.end()) {
-        throw InterpreterSemanticError("Error: Symbol '" + sym + "' not found");
+    const EnvResult* result = find(sym);
+    if (result == nullptr) {
+        throw InterpreterSemanticError("Error: Symbol '" + sym.name() + "' not found");
+    }
+    return *result;  // returns procedure or expression
+}
+
+
+Procedure Environment::getProcedure(const Symbol& sym) const {
+    const EnvResult* result = find(sym);
+    return result == nullptr ? nullptr : result->builtin;
+}
+
+// true if all count types are type
+static bool all_of_type(const Type* types, std::uint32_t count, Type type) {
+    return std::all_of(types, types + count, [type](Type t) { return t == type; });
+}
+
+Type Environment::callType(const Symbol& op, const Type* types, std::uint32_t count, Procedure& unchecked) const {
+    unchecked = nullptr;
+    if (!op.isKeyword() || find(op) != &builtins[op.id]) { // rebound by the host
+        return NoneType;
+    }
+
+    bool numbers = all_of_type(types, count, NumberType);
+    bool booleans = all_of_type(types, count, BooleanType);
+    switch (op.id) {
+    // arithmetic on lists gives lists
+    case AddId:
+        unchecked = numbers ? add_numbers : nullptr;
+        return numbers ? NumberType : NoneType;
+    case MultiplyId:
+        unchecked = numbers ? multiply_numbers : nullptr;
+        return numbers ? NumberType : NoneType;
+    case SubtractId:
+        unchecked = numbers && (count == 1 || count == 2) ? subtract_numbers : nullptr;
+        return unchecked != nullptr ? NumberType : NoneType;
+    case DivideId:
+        unchecked = numbers && count == 2 ? divide_numbers : nullptr;
+        return unchecked != nullptr ? NumberType : NoneType;
+    case SqrtId:
+        unchecked = numbers && count == 1 ? sqrt_number : nullptr;
+        return unchecked != nullptr ? NumberType : NoneType;
+    case Log2Id:
+        unchecked = numbers && count == 1 ? log2_number : nullptr;
+        return NumberType;
+
+    // comparisons and logical operators only give booleans
+    case LessId:
+        unchecked = numbers && count == 2 ? less_numbers : nullptr;
+        return BooleanType;
+    case LessEqualId:
+        unchecked = numbers && count == 2 ? less_equal_numbers : nullptr;
+        return BooleanType;
+    case GreaterId:
+        unchecked = numbers && count == 2 ? greater_numbers : nullptr;
+        return BooleanType;
+    case GreaterEqualId:
+        unchecked = numbers && count == 2 ? greater_equal_numbers : nullptr;
+        return BooleanType;
+    case EqualId:
+        unchecked = numbers && count == 2 ? equal_numbers : nullptr;
+        return BooleanType;
+    case AndId:
+        unchecked = booleans ? and_booleans : nullptr;
+        return BooleanType;
+    case OrId:
+        unchecked = booleans ? or_booleans : nullptr;
+        return BooleanType;
+    case NotId:
+        unchecked = booleans && count == 1 ? not_boolean : nullptr;
+        return BooleanType;
+
+    case SinId:
+        unchecked = numbers && count == 1 ? sin_number : nullptr;
+        return unchecked != nullptr ? NumberType : NoneType;
+    case CosId:
+        unchecked = numbers && count == 1 ? cos_number : nullptr;
+        return unchecked != nullptr ? NumberType : NoneType;
+    case ArctanId:
+        unchecked = numbers && count == 2 ? arctan_numbers : nullptr;
+        return NumberType;
+    case RangeId:
+    case LinspaceId:
+        return ListType;
+
+    // each graphic builtin makes one type
+    case PointId:
+        unchecked = numbers && count == 2 ? point_numbers : nullptr;
+        return PointType;
+    case LineId:
+        if (count == 2 && all_of_type(types, count, PointType)) {
+            unchecked = line_points;
+        }
+        else if (count == 4 && numbers) {
+            unchecked = line_numbers;
+        }
+        return LineType;
+    case ArcId:
+        if (count == 3 && types[0] == PointType && types[1] == PointType && types[2] == NumberType) {
+            unchecked = arc_points;
+        }
+        else if (count == 5 && numbers) {
+            unchecked = arc_numbers;
+        }
+        return ArcType;
+    case RectId:
+        unchecked = count == 2 && all_of_type(types, count, PointType) ? rect_points : nullptr;
+        return RectType;
+    case FillRectId:
+        unchecked = count == 4 && types[0] == RectType && all_of_type(types + 1, 3, NumberType) ? fill_rect_color : nullptr;
+        return FillRectType;
+    case EllipseId:
+        unchecked = count == 1 && types[0] == RectType ? ellipse_rect : nullptr;
+        return EllipseType;
+    case DrawId: // draws, so it keeps its checks
+        return count != 0 && std::all_of(types, types + count, is_graphic) ? types[count - 1] : NoneType;
+    default:
+        return NoneType;
     }
-    return it->second;  // returns procedure or expression
 }
 
+std::uint64_t Environment::version() const {
+    return bindings;
+}
+
+std::uint64_t Environment::stamp(const Symbol& sym) const {
+    const EnvResult* result = find(sym);
+    return result == nullptr ? 0 : result->stamp;
+}
 
-bool Environment::isKeyword(const std::string& symbol) {
-    static const std::set<std::string> keywords = { "+", "-", "*", "/", "sqrt", "log2", "and", "or", "not", "<", "<=", ">", ">=", "==" , "define", "begin", "if", "pi", "True", "False", "sin", "cos", "arctan", "point", "line", "arc", "draw", "rect", "fill_rect", "ellipse"};
-    return keywords.find(symbol) != keywords.end();
+bool Environment::isKeyword(const Symbol& symbol) {
+    return symbol.isKeyword();
 }
 
 
-EnvResult::EnvResult() : type(ExpressionType), exp(Expression()), proc(nullptr) {}
+EnvResult::EnvResult() : type(UnboundType), exp(Expression()), proc(nullptr), builtin(nullptr) {}
 
 EnvResult::EnvResult(EnvResultType eType, Expression eExp)
-    : type(eType), exp(eExp), proc(nullptr) {}
+    : type(eType), exp(eExp), proc(nullptr), builtin(nullptr) {}
 
 EnvResult::EnvResult(EnvResultType eType, std::function<Expression(Environment&, const std::vector<Atom>&)> eProc)
-    : type(eType), exp(Expression()), proc(eProc) {}
\ No newline at end of file
+    : type(eType), exp(Expression()), proc(eProc), builtin(nullptr) {}
+
+EnvResult::EnvResult(Procedure eBuiltin)
+    : type(ProcedureType), exp(Expression()), builtin(eBuiltin) {
+    proc = [eBuiltin](Environment&, const std::vector<Atom>& args) {
+        Atom result;
+        EvalError error;
+        if (!eBuiltin(args, result, error)) {
+            throw InterpreterSemanticError(error.message());
+        }
+        return Expression(result);
+    };
+}
\ No newline at end of file
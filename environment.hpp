@@ -5,29 +5,37 @@
 #include <unordered_map>
 #include <string>
 #include <vector>
-#include <set> 
 #include <functional>
+#include <cstdint>
 
 // module includes
 #include "expression.hpp"
+#include "eval_error.hpp"
 
 class Environment;
 
-enum EnvResultType { ExpressionType, ProcedureType };
+enum EnvResultType { ExpressionType, ProcedureType, UnboundType };
 
 struct EnvResult {
     EnvResultType type;
     Expression exp;
     std::function<Expression(Environment&, const std::vector<Atom>&)> proc;
+    Procedure builtin; // the function proc forwards to, nullptr unless a builtin
+    std::uint64_t stamp = 0; // when the binding was made, see Environment::stamp
 
-    EnvResult(); // Default constructor
+    EnvResult(); // Default constructor, unbound
     EnvResult(EnvResultType eType, Expression eExp); // for ExpressionType
     EnvResult(EnvResultType eType, std::function<Expression(Environment&, const std::vector<Atom>&)> eProc); // for ProcedureType
+    explicit EnvResult(Procedure eBuiltin); // for builtin procedures
 };
 
 class Environment {
 public:
-    std::unordered_map<Symbol, EnvResult> envmap;
+    // the shared bindings of the keywords, indexed by KeywordId
+    const EnvResult* builtins;
+    // bindings defined in this environment, keyed by SymbolId. A keyword
+    // defined here hides its builtin binding until reset
+    std::unordered_map<SymbolId, EnvResult> envmap;
 
     Environment();
     void reset();
@@ -37,47 +45,89 @@ public:
     bool isDefined(const Symbol& sym) const;
     Expression get(const Symbol& sym) const;
 
+    // the value bound to sym, else false with an UnboundSymbolError or
+    // NotExpressionError. Does not throw
+    bool get(const Symbol& sym, Atom& value, EvalError& error) const;
+
+    // call the procedure bound to sym, else false with the error. Errors
+    // thrown by procedures the host defined are returned in error
+    bool call(const Symbol& sym, const std::vector<Atom>& args, Atom& result, EvalError& error);
+
     EnvResult getResult(const Symbol& sym) const;
     bool isProcedure(const Symbol& sym) const;
-    static bool isKeyword(const std::string& symbol);
+    static bool isKeyword(const Symbol& symbol);
+
+    // direct pointer to the builtin bound to sym, nullptr for any other binding.
+    // Callers may keep it while version() is unchanged
+    Procedure getProcedure(const Symbol& sym) const;
+
+    // the type of the value calling op gives for arguments of the given
+    // types, NoneType where a type is not known. unchecked is set to a
+    // variant of the builtin without its type checks if the types prove
+    // they pass, else nullptr. Only builtins still bound have known types
+    Type callType(const Symbol& op, const Type* types, std::uint32_t count, Procedure& unchecked) const;
+
+    // changes whenever a procedure binding or a keyword slot is redefined
+    std::uint64_t version() const;
+
+    // stamp of the binding of sym, 0 if unbound. Every define gives a new
+    // stamp, so a symbol kept its value while its stamp is unchanged
+    std::uint64_t stamp(const Symbol& sym) const;
 
 
 private:
+    std::uint64_t bindings = 0; // version of the procedure bindings
+    std::uint64_t stamps = KeywordCount; // last stamp given to a binding
+    std::uint64_t overridden = 0; // bit k set if keyword k is bound in envmap
+    static_assert(KeywordCount <= 64, "overridden has a bit per keyword");
+
+    static const EnvResult* builtinTable();
+
+    // store result as the binding of sym with a new stamp
+    void bind(const Symbol& sym, const EnvResult& result);
+
+    // binding of sym, nullptr if unbound
+    const EnvResult* find(const Symbol& sym) const;
+
     // Arithmetic operations
-    static Expression add(const std::vector<Atom>& args);
-    static Expression subtract(const std::vector<Atom>& args);
-    static Expression multiply(const std::vector<Atom>& args);
-    static Expression divide(const std::vector<Atom>& args);
+    static bool add(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool subtract(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool multiply(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool divide(const std::vector<Atom>& args, Atom& result, EvalError& error);
 
     // Comparison operations
-    static Expression less_than(const std::vector<Atom>& args);
-    static Expression less_than_equal(const std::vector<Atom>& args);
-    static Expression greater_than(const std::vector<Atom>& args);
-    static Expression greater_than_equal(const std::vector<Atom>& args);
-    static Expression equal_to(const std::vector<Atom>& args);
+    static bool less_than(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool less_than_equal(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool greater_than(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool greater_than_equal(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool equal_to(const std::vector<Atom>& args, Atom& result, EvalError& error);
 
     // Logical operations
-    static Expression logical_and(const std::vector<Atom>& args);
-    static Expression logical_or(const std::vector<Atom>& args);
-    static Expression logical_not(const std::vector<Atom>& args);
-    static Expression sqrt(const std::vector<Atom>& args);
-    static Expression log2(const std::vector<Atom>& args);
+    static bool logical_and(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool logical_or(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool logical_not(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool sqrt(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool log2(const std::vector<Atom>& args, Atom& result, EvalError& error);
 
     // Trig Functions
-    static Expression sin_func(const std::vector<Atom>& args);
-    static Expression cos_func(const std::vector<Atom>& args);
-    static Expression arctan(const std::vector<Atom>& args);
+    static bool sin_func(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool cos_func(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool arctan(const std::vector<Atom>& args, Atom& result, EvalError& error);
+
+    // Lists
+    static bool range(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool linspace(const std::vector<Atom>& args, Atom& result, EvalError& error);
 
     // graphicss
-    static Expression point(const std::vector<Atom>& args);
-    static Expression line(const std::vector<Atom>& args);
-    static Expression arc(const std::vector<Atom>& args);
-    static Expression rect(const std::vector<Atom>& args);
-    static Expression fill_rect(const std::vector<Atom>& args);
-    static Expression ellipse(const std::vector<Atom>& args);
+    static bool point(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool line(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool arc(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool rect(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool fill_rect(const std::vector<Atom>& args, Atom& result, EvalError& error);
+    static bool ellipse(const std::vector<Atom>& args, Atom& result, EvalError& error);
 
 
-    static Expression draw(const std::vector<Atom>& args);
+    static bool draw(const std::vector<Atom>& args, Atom& result, EvalError& error);
 };
 
 #endif
\ No newline at end of file
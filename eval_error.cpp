@@ -0,0 +1,42 @@
+#include "eval_error.hpp"
+
+bool EvalError::fail(ErrorCode code, const char* text) {
+    this->code = code;
+    this->text = text;
+    detail.clear();
+    return false;
+}
+
+bool EvalError::fail(ErrorCode code, SymbolId symbol) {
+    this->code = code;
+    this->symbol = symbol;
+    detail.clear();
+    return false;
+}
+
+bool EvalError::fail(ErrorCode code, const std::string& detail) {
+    this->code = code;
+    this->detail = detail;
+    return false;
+}
+
+std::string EvalError::message() const {
+    switch (code) {
+    case NoError:
+        return std::string();
+    case InvalidTokenError:
+        return "Error: Invalid token '" + detail + "'";
+    case InvalidSymbolError:
+        return "Error: Invalid symbol '" + Symbol::fromId(symbol).name() + "'";
+    case UnrecognizedKeywordError:
+        return "Error: Unrecognized keyword '" + Symbol::fromId(symbol).name() + "'";
+    case UnboundSymbolError:
+        return "Error: Symbol '" + Symbol::fromId(symbol).name() + "' not found";
+    case NotExpressionError:
+        return "Error: Symbol '" + Symbol::fromId(symbol).name() + "' is not an expression";
+    case UnknownProcedureError:
+        return "Error: Unknown procedure '" + Symbol::fromId(symbol).name() + "'";
+    default:
+        return detail.empty() ? std::string(text) : detail;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef EVAL_ERROR_HPP
+#define EVAL_ERROR_HPP
+
+// system includes
+#include <string>
+
+// module includes
+#include "expression.hpp"
+
+// what went wrong in a parse or evaluation, the parse errors come first
+enum ErrorCode {
+    NoError,
+
+    // parse errors
+    SyntaxError,              // malformed input
+    InvalidTokenError,        // a token that is no atom, detail is its text
+    InvalidSymbolError,       // a symbol outside of a list
+    UnrecognizedKeywordError, // a list whose operator is no keyword
+
+    // evaluation errors
+    UnboundSymbolError,       // a symbol with no binding
+    NotExpressionError,       // a procedure used as a value
+    UnknownProcedureError,    // an operator not bound to a procedure
+    SpecialFormError,         // a misused define, begin or if
+    ArgumentError,            // a procedure rejected its arguments
+    DepthError                // evaluation nested deeper than the limit
+};
+
+// An EvalError holds what message() needs to describe an error: a static
+// text, a symbol or a token. The message is only formatted when asked for,
+// so failing costs no allocation
+struct EvalError {
+    ErrorCode code = NoError;
+    const char* text = "";     // the message of text errors
+    SymbolId symbol = EmptyId; // the symbol named by symbol errors
+    std::string detail;        // the token named by InvalidTokenError, or the
+                               // message of an exception thrown by a procedure
+
+    // record an error, these return false so callers can return fail(...)
+    bool fail(ErrorCode code, const char* text);
+    bool fail(ErrorCode code, SymbolId symbol);
+    bool fail(ErrorCode code, const std::string& detail);
+
+    bool ok() const { return code == NoError; }
+    bool parseError() const { return code >= SyntaxError && code <= UnrecognizedKeywordError; }
+
+    // the message InterpreterSemanticError carries for this error
+    std::string message() const;
+};
+
+// the value of an evaluation, or the error that stopped it
+struct EvalResult {
+    Expression value;
+    EvalError error;
+
+    bool ok() const { return error.ok(); }
+};
+
+#endif
@@ -1,9 +1,52 @@
 #include "expression.hpp"
+#include "keywords.hpp"
 
 #include <cmath>
 #include <limits>
 #include <cctype>
 #include <sstream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+#include <new>
+#include <algorithm>
+
+// keywords have fixed ids, found without locking the table
+Symbol::Symbol(const std::string& name) : Symbol(name.data(), name.size()) {
+}
+
+Symbol::Symbol(const char* name) : Symbol(name, std::strlen(name)) {
+}
+
+Symbol::Symbol(const char* name, std::size_t length) : id(find_keyword(name, length)) {
+    if (id == KeywordCount) {
+        id = SymbolTable::global().intern(name, length);
+    }
+}
+
+Symbol Symbol::fromId(SymbolId id) {
+    Symbol sym;
+    sym.id = id;
+    return sym;
+}
+
+const std::string& Symbol::name() const {
+    return SymbolTable::global().name(id);
+}
+
+bool operator==(const Symbol& left, const std::string& right) {
+    return left.name() == right;
+}
+
+bool operator==(const Symbol& left, const char* right) {
+    return left.name() == right;
+}
+
+std::ostream& operator<<(std::ostream& out, const Symbol& sym) {
+    out << sym.name();
+    return out;
+}
 
 Expression::Expression(bool tf) {
     head.type = BooleanType;
@@ -20,6 +63,28 @@ Expression::Expression(const std::string& sym) {
     head.value.sym_value = sym;
 }
 
+Atom make_list(std::size_t size, double*& data) {
+    void* memory = ::operator new(sizeof(ListStorage) + size * sizeof(double));
+    ListStorage* storage = new (memory) ListStorage(size);
+
+    Atom atom;
+    atom.type = ListType;
+    atom.value.list_value.storage = storage;
+    data = storage->data();
+    return atom;
+}
+
+void Atom::free_list(ListStorage* storage) {
+    storage->~ListStorage();
+    ::operator delete(storage);
+}
+
+Expression::Expression(const std::vector<double>& numbers) {
+    double* data;
+    head = make_list(numbers.size(), data);
+    std::copy(numbers.begin(), numbers.end(), data);
+}
+
 bool Expression::operator==(const Expression& exp) const noexcept {
     if (head.type != exp.head.type) {
         return false;
@@ -44,6 +109,19 @@ bool Expression::operator==(const Expression& exp) const noexcept {
         }
     }
       break;
+    case ListType: {
+        const List& left = head.value.list_value;
+        const List& right = exp.head.value.list_value;
+        if (left.size() != right.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < left.size(); ++i) {
+            if (fabs(left.data()[i] - right.data()[i]) > std::numeric_limits<double>::epsilon()) {
+                return false;
+            }
+        }
+    }
+        break;
     case SymbolType:
         if (head.value.sym_value != exp.head.value.sym_value) {
             return false;
@@ -108,6 +186,15 @@ std::string Expression::toString() const {
     case NumberType:
         oss << "(" << head.value.num_value << ")";
         break;
+    case ListType: {
+        const List& list = head.value.list_value;
+        oss << "(";
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            oss << (i == 0 ? "" : " ") << list.data()[i];
+        }
+        oss << ")";
+        break;
+    }
     case SymbolType:
         oss << "(" << head.value.sym_value << ")";
         break;
@@ -212,41 +299,155 @@ Expression::Expression(const Rectt& boundingRect) {
 
 
 
-bool token_to_atom(const std::string& token, Atom& atom) {
-    // is token boolean keyword
-    if (token == "True") {
-        atom.type = BooleanType;
-        atom.value.bool_value = true;
+// powers of ten that are exact as doubles
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// convert text[0, length) with strtod, only for numbers the fast path cannot round
+static double slow_convert(const char* text, std::size_t length) {
+    char buffer[128];
+    std::string copy;
+    char* chars = buffer;
+    if (length >= sizeof(buffer)) { // very long literal
+        copy.resize(length + 1);
+        chars = &copy[0];
     }
-    else if (token == "False") {
-        atom.type = BooleanType;
-        atom.value.bool_value = false;
+
+    // strtod reads the decimal point of the C locale, which Qt may have changed
+    char point = std::localeconv()->decimal_point[0];
+    for (std::size_t i = 0; i < length; ++i) {
+        chars[i] = (text[i] == '.') ? point : text[i];
     }
-    else {
-        // is token a number
-        double temp;
+    chars[length] = '\0';
 
-        std::istringstream iss(token);
-        if (iss >> temp) {
-            // check for trailing characters if >> succeeds
-            if (iss.rdbuf()->in_avail() != 0) {
-                return false;
-            }
+    return std::strtod(chars, nullptr);
+}
+
+std::size_t scan_number(const char* text, std::size_t length, double& value) {
+    std::size_t i = 0;
+    bool negative = false;
+    if (i < length && (text[i] == '+' || text[i] == '-')) {
+        negative = (text[i] == '-');
+        ++i;
+    }
+
+    // up to 19 significant digits fit in the mantissa, the rest only scale it
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool any_digit = false;
 
-            atom.type = NumberType;
-            atom.value.num_value = temp;
+    for (; i < length && std::isdigit(static_cast<unsigned char>(text[i])); ++i) {
+        int d = text[i] - '0';
+        any_digit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + d;
+            digits += (mantissa != 0);
         }
         else {
-            // else assume symbol
-            atom.type = SymbolType;
-            atom.value.sym_value = token;
+            ++exponent;
+            truncated = truncated || d != 0;
+        }
+    }
+    if (i < length && text[i] == '.') {
+        ++i;
+        for (; i < length && std::isdigit(static_cast<unsigned char>(text[i])); ++i) {
+            int d = text[i] - '0';
+            any_digit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + d;
+                digits += (mantissa != 0);
+                --exponent;
+            }
+            else {
+                truncated = truncated || d != 0;
+            }
+        }
+    }
+    if (!any_digit) {
+        return 0;
+    }
 
-            // make sure does not start with number
-            if (std::isdigit(token[0]) != 0) {
-                return false;
+    // the exponent is only part of the number if it has digits
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        std::size_t j = i + 1;
+        bool negative_exponent = false;
+        if (j < length && (text[j] == '+' || text[j] == '-')) {
+            negative_exponent = (text[j] == '-');
+            ++j;
+        }
+        if (j < length && std::isdigit(static_cast<unsigned char>(text[j]))) {
+            int e = 0;
+            for (; j < length && std::isdigit(static_cast<unsigned char>(text[j])); ++j) {
+                if (e < 100000) {
+                    e = e * 10 + (text[j] - '0');
+                }
             }
+            exponent += negative_exponent ? -e : e;
+            i = j;
         }
     }
 
+    // exact when both the mantissa and the power of ten are exact doubles,
+    // a single multiply or divide is then correctly rounded
+    if (mantissa == 0) {
+        value = negative ? -0.0 : 0.0;
+    }
+    else if (!truncated && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        double m = static_cast<double>(mantissa);
+        value = exponent < 0 ? m / exact_powers_of_ten[-exponent] : m * exact_powers_of_ten[exponent];
+        value = negative ? -value : value;
+    }
+    else {
+        value = slow_convert(text, i);
+    }
+
+    return i;
+}
+
+bool token_to_atom(const char* token, std::size_t length, Atom& atom) {
+    // is token a keyword, boolean literals among them
+    KeywordId keyword = find_keyword(token, length);
+    if (keyword == TrueId || keyword == FalseId) {
+        atom.type = BooleanType;
+        atom.value.bool_value = (keyword == TrueId);
+        return true;
+    }
+    if (keyword != KeywordCount) {
+        atom.type = SymbolType;
+        atom.value.sym_value = Symbol::fromId(keyword);
+        return true;
+    }
+
+    // is token a number
+    double temp;
+    std::size_t used = scan_number(token, length, temp);
+    if (used != 0) {
+        // trailing characters or out of range
+        if (used != length || std::isinf(temp)) {
+            return false;
+        }
+
+        atom.type = NumberType;
+        atom.value.num_value = temp;
+        return true;
+    }
+
+    // make sure does not start with number
+    if (length != 0 && std::isdigit(static_cast<unsigned char>(token[0])) != 0) {
+        return false;
+    }
+
+    // else assume symbol, interned here so later stages compare ids
+    atom.type = SymbolType;
+    atom.value.sym_value = Symbol(token, length);
+
     return true;
 }
+
+bool token_to_atom(const std::string& token, Atom& atom) {
+    return token_to_atom(token.data(), token.size(), atom);
+}
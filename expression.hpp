@@ -6,6 +6,11 @@
 #include <vector>
 #include <tuple>
 #include <iostream>
+#include <cstddef>
+#include <atomic>
+
+// module includes
+#include "symbol_table.hpp"
 
 
 // A Type is a literal boolean, literal number, or symbol
@@ -29,8 +34,41 @@ typedef bool Boolean;
 // A Number is a C++ double
 typedef double Number;
 
-// A Symbol is a string
-typedef std::string Symbol;
+// A Symbol is a name interned in the global SymbolTable,
+// it is stored and compared as its integer id
+struct Symbol {
+    SymbolId id;
+
+    Symbol() : id(EmptyId) {}
+
+    Symbol(const std::string& name);
+
+    Symbol(const char* name);
+
+    Symbol(const char* name, std::size_t length);
+
+    static Symbol fromId(SymbolId id);
+
+    const std::string& name() const;
+
+    bool isKeyword() const {
+        return id != EmptyId && id < KeywordCount;
+    }
+};
+
+inline bool operator==(const Symbol& left, const Symbol& right) {
+    return left.id == right.id;
+}
+
+inline bool operator!=(const Symbol& left, const Symbol& right) {
+    return left.id != right.id;
+}
+
+// compare with a name without interning it
+bool operator==(const Symbol& left, const std::string& right);
+bool operator==(const Symbol& left, const char* right);
+
+std::ostream& operator<<(std::ostream& out, const Symbol& sym);
 
 
 struct Point {
@@ -63,27 +101,108 @@ struct Ellipsee {
     Rectt rect; 
 };
 
-// A Value is a boolean, number, or symbol
-// cannot use a union because symbol is non-POD
-// this wastes space but is simple 
-struct Value {
+// storage of a List: a reference count and size followed by the numbers
+struct ListStorage {
+    std::atomic<std::size_t> refs;
+    std::size_t size;
+
+    explicit ListStorage(std::size_t count) : refs(1), size(count) {}
+
+    double* data() {
+        return reinterpret_cast<double*>(this + 1);
+    }
+};
+
+// A List is a contiguous array of numbers. The storage is shared by every
+// Atom holding the list and freed with the last one, the numbers are not
+// changed once the list is shared
+struct List {
+    ListStorage* storage;
+
+    std::size_t size() const {
+        return storage->size;
+    }
+
+    const double* data() const {
+        return storage->data();
+    }
+};
+
+// A Value is a boolean, number, list, symbol or graphic. The members share
+// storage, the Type of the Atom holding the Value says which one is set.
+// Symbols are interned ids and lists are pointers, so every member is
+// trivially copyable and the largest one (FillRectt, 7 doubles) sets the size
+union Value {
     Boolean bool_value;
     Number num_value;
+    List list_value;
     Symbol sym_value;
-    Point point_value;  
-    Line line_value;    
+    Point point_value;
+    Line line_value;
     Arcn arc_value;
     Rectt rect_value;
     FillRectt fill_rect_value;
     Ellipsee ellipse_value;
+
+    // zero every member
+    Value() : fill_rect_value() {}
 };
 
-// An Atom has a type and value
+// An Atom has a type and value. Copies of a list Atom share its storage
 struct Atom {
     Type type;
     Value value;
+
+    Atom() : type(NoneType) {}
+
+    Atom(const Atom& other) : type(other.type), value(other.value) {
+        if (type == ListType) {
+            ++value.list_value.storage->refs;
+        }
+    }
+
+    Atom(Atom&& other) noexcept : type(other.type), value(other.value) {
+        other.type = NoneType;
+    }
+
+    Atom& operator=(const Atom& other) {
+        if (other.type == ListType) {
+            ++other.value.list_value.storage->refs;
+        }
+        release();
+        type = other.type;
+        value = other.value;
+        return *this;
+    }
+
+    Atom& operator=(Atom&& other) noexcept {
+        if (this != &other) {
+            release();
+            type = other.type;
+            value = other.value;
+            other.type = NoneType;
+        }
+        return *this;
+    }
+
+    ~Atom() {
+        release();
+    }
+
+private:
+    // drop this Atom's reference to its list
+    void release() {
+        if (type == ListType && --value.list_value.storage->refs == 0) {
+            free_list(value.list_value.storage);
+        }
+    }
+
+    static void free_list(ListStorage* storage);
 };
 
+// a list Atom of size numbers, data points to its storage to fill in
+Atom make_list(std::size_t size, double*& data);
+
 // An expression is an atom called the head
 // followed by a (possibly empty) list of expressions
 // called the tail
@@ -124,6 +243,9 @@ struct Expression {
     // constructor for ellipse
     Expression(const Rectt& boundingRect);
 
+    // constructor for list
+    explicit Expression(const std::vector<double>& numbers);
+
     bool operator==(const Expression& exp) const noexcept;
 
     std::string toString() const;
@@ -131,9 +253,12 @@ struct Expression {
 };
 
 
-// A Procedure is a C++ function pointer taking
-// a vector of Atoms as arguments
-typedef Expression(*Procedure)(const std::vector<Atom>& args);
+struct EvalError;
+
+// A Procedure is a C++ function pointer taking a vector of Atoms as
+// arguments. It stores its value in result and returns true, or
+// describes the problem in error and returns false
+typedef bool(*Procedure)(const std::vector<Atom>& args, Atom& result, EvalError& error);
 
 // format an expression for output
 std::ostream& operator<<(std::ostream& out, const Expression& exp);
@@ -141,4 +266,12 @@ std::ostream& operator<<(std::ostream& out, const Expression& exp);
 // map a token to an Atom
 bool token_to_atom(const std::string& token, Atom& atom);
 
+// map a token given as a range of characters to an Atom
+bool token_to_atom(const char* token, std::size_t length, Atom& atom);
+
+// scan the longest decimal number [+-]digits[.digits][(e|E)[+-]digits] at
+// the start of text into value, correctly rounded and without allocating.
+// Returns the number of characters used, 0 if text does not start with a number
+std::size_t scan_number(const char* text, std::size_t length, double& value);
+
 #endif
@@ -0,0 +1,100 @@
+#include "form_reader.hpp"
+
+FormReader::FormReader(std::istream& input, std::size_t chunk_size)
+    : input(input), chunk_size(chunk_size), start(std::string::npos) {}
+
+bool FormReader::fill() {
+    std::size_t size = buffer.size();
+    buffer.resize(size + chunk_size);
+    input.read(&buffer[size], static_cast<std::streamsize>(chunk_size));
+    buffer.resize(size + static_cast<std::size_t>(input.gcount()));
+    return buffer.size() != size;
+}
+
+void FormReader::emit(std::size_t end, std::string& form) {
+    form.assign(buffer, start, end - start);
+    scan = end;
+    consumed = offset + end;
+    ++forms;
+
+    start = std::string::npos;
+    depth = 0;
+    atom = false;
+}
+
+bool FormReader::next(std::string& form) {
+    for (;;) {
+        while (scan < buffer.size()) {
+            char ch = buffer[scan];
+
+            if (comment) { // skip to end of line
+                comment = (ch != '\n');
+                ++scan;
+                continue;
+            }
+
+            bool space = (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r');
+
+            if (atom) { // a bare atom ends at the next delimiter
+                if (space || ch == '(' || ch == ')' || ch == ';') {
+                    emit(scan, form);
+                    return true;
+                }
+                ++scan;
+                continue;
+            }
+
+            if (ch == ';') {
+                comment = true;
+            }
+            else if (ch == '(') {
+                if (start == std::string::npos) {
+                    start = scan;
+                }
+                ++depth;
+            }
+            else if (ch == ')') {
+                if (start == std::string::npos) { // stray close paren
+                    start = scan;
+                    emit(scan + 1, form);
+                    return true;
+                }
+                if (--depth == 0) {
+                    emit(scan + 1, form);
+                    return true;
+                }
+            }
+            else if (!space && start == std::string::npos) {
+                start = scan;
+                atom = true;
+            }
+            ++scan;
+        }
+
+        // drop the consumed text, keeping only the start of the current form
+        std::size_t keep = (start == std::string::npos) ? scan : start;
+        buffer.erase(0, keep);
+        offset += keep;
+        scan -= keep;
+        if (start != std::string::npos) {
+            start -= keep;
+        }
+
+        if (!fill()) {
+            if (start != std::string::npos) { // unterminated form at end of input
+                emit(buffer.size(), form);
+                return true;
+            }
+            consumed = offset + buffer.size();
+            return false;
+        }
+    }
+}
+
+std::size_t FormReader::formsRead() const {
+    return forms;
+}
+
+std::size_t FormReader::bytesConsumed() const {
+    return consumed;
+}
@@ -0,0 +1,53 @@
+#ifndef FORM_READER_HPP
+#define FORM_READER_HPP
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// FormReader pulls complete top-level forms out of a stream one at a time.
+// It reads the stream in fixed size chunks and only holds the form being
+// scanned in memory, so scripts of any size can be processed form by form.
+//
+// A top-level form is a balanced parenthesized expression or a bare atom.
+// Comments between forms are dropped, comments inside a form are kept and
+// left to the tokenizer. A stray ")" is returned as a form of its own and an
+// unterminated form is returned as is at the end of input, so that the
+// parser reports the same errors it would for the whole text.
+class FormReader {
+public:
+    explicit FormReader(std::istream& input, std::size_t chunk_size = 64 * 1024);
+
+    // read the next top-level form into form, returns false at end of input
+    bool next(std::string& form);
+
+    // number of forms returned by next so far
+    std::size_t formsRead() const;
+
+    // number of bytes of the stream consumed by the forms returned so far,
+    // including the comments and whitespace before them
+    std::size_t bytesConsumed() const;
+
+private:
+    std::istream& input;
+    std::size_t chunk_size;
+
+    std::string buffer;          // unconsumed text read from the stream
+    std::size_t offset = 0;      // position of buffer[0] in the stream
+    std::size_t scan = 0;        // position in buffer the scanner has reached
+    std::size_t start;           // start of the current form in buffer, npos if none
+    std::size_t depth = 0;       // parenthesis nesting of the current form
+    bool comment = false;        // inside a ; comment
+    bool atom = false;           // current form is a bare atom
+
+    std::size_t forms = 0;
+    std::size_t consumed = 0;
+
+    // read another chunk into buffer, returns false at end of input
+    bool fill();
+
+    // hand out buffer[start, end) as form and continue scanning after it
+    void emit(std::size_t end, std::string& form);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "geometry_sink.hpp"
+
+void GeometrySink::setHandler(std::size_t batch, Handler handler) {
+    this->batch = batch == 0 ? 1 : batch;
+    this->handler = handler;
+    pending.reserve(this->batch);
+}
+
+void GeometrySink::draw(const Atom* graphics, std::size_t count) {
+    total += count;
+    for (std::size_t i = 0; i < count; ++i) {
+        pending.push_back(graphics[i]);
+        if (handler && pending.size() >= batch) {
+            flush();
+        }
+    }
+}
+
+void GeometrySink::flush() {
+    if (handler && !pending.empty()) {
+        handler(pending);
+        pending.clear();
+    }
+}
+
+const std::vector<Atom>& GeometrySink::graphics() const {
+    return pending;
+}
+
+void GeometrySink::clear() {
+    pending.clear();
+}
+
+std::size_t GeometrySink::drawn() const {
+    return total;
+}
@@ -0,0 +1,45 @@
+#ifndef GEOMETRY_SINK_HPP
+#define GEOMETRY_SINK_HPP
+
+// system includes
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+
+// A GeometrySink collects the graphics draw is called with while a
+// program is evaluated, in the order they are drawn. With a handler set,
+// every full batch is passed to it as soon as it is drawn and dropped,
+// so a long drawing is shown while it runs and is never held whole.
+// Without one the graphics are kept until cleared, the Interpreter
+// clears them when it starts an evaluation
+class GeometrySink {
+public:
+    typedef std::function<void(const std::vector<Atom>& graphics)> Handler;
+
+    // pass graphics to handler in batches of batch, nullptr to keep them
+    void setHandler(std::size_t batch, Handler handler);
+
+    // append count graphics, passing a batch to the handler once full
+    void draw(const Atom* graphics, std::size_t count);
+
+    // pass the graphics not passed yet to the handler
+    void flush();
+
+    // the graphics not passed to a handler
+    const std::vector<Atom>& graphics() const;
+    void clear();
+
+    // number of graphics drawn since constructed
+    std::size_t drawn() const;
+
+private:
+    std::vector<Atom> pending;
+    std::size_t batch = 0;
+    Handler handler;
+    std::size_t total = 0;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "headless_render.hpp"
+
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "display_list_item.hpp"
+#include "interpreter.hpp"
+#include "qt_interpreter.hpp"
+
+#ifdef PLDRAW_HAVE_SVG
+#include <QSvgGenerator>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// milliseconds from start to now
+static double millis(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// messages of builtins do not all start with Error
+static std::string error_text(const std::string& message) {
+    return message.compare(0, 5, "Error") == 0 ? message : "Error: " + message;
+}
+
+// evaluate the script at path, adding all it draws to list
+static bool evaluate_script(const std::string& path, DisplayListItem& list) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "Error: could not open file '" << path << "'" << std::endl;
+        return false;
+    }
+    std::string program((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    Interpreter interpreter;
+    interpreter.geometry().setHandler(QtInterpreter::DrawBatch, [&list](const std::vector<Atom>& graphics) {
+        for (const Atom& graphic : graphics) {
+            add_graphic(list, graphic);
+        }
+    });
+
+    EvalError error;
+    if (interpreter.tryParse(program, error)) {
+        EvalResult result = interpreter.tryEval();
+        if (result.ok()) {
+            if (interpreter.geometry().drawn() == 0) { // shown as pldraw shows it
+                add_graphic(list, result.value.head);
+            }
+            return true;
+        }
+        error = result.error;
+    }
+    std::cerr << error_text(error.message()) << std::endl;
+    return false;
+}
+
+// paint list on a white background of size, centered, at scale pixels per
+// unit or fit with a margin if scale is 0
+static void paint_list(QPainter& painter, DisplayListItem& list, QSize size, double scale) {
+    painter.fillRect(QRect(QPoint(0, 0), size), Qt::white);
+    QRectF bounds = list.boundingRect();
+    if (list.size() == 0) {
+        return;
+    }
+
+    if (scale <= 0) {
+        const double margin = 0.95;
+        double sx = bounds.width() > 0 ? size.width() * margin / bounds.width() : 1;
+        double sy = bounds.height() > 0 ? size.height() * margin / bounds.height() : 1;
+        scale = std::min(sx, sy);
+    }
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(size.width() / 2.0, size.height() / 2.0);
+    painter.scale(scale, scale);
+    painter.translate(-bounds.center());
+
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = bounds;
+    list.paint(&painter, &option, nullptr);
+}
+
+int render_script(const RenderOptions& options) {
+    QString output = QString::fromStdString(options.output);
+    QString suffix = QFileInfo(output).suffix().toLower();
+    if (suffix != "png" && suffix != "svg") {
+        std::cerr << "Error: output must be a .png or .svg file" << std::endl;
+        return EXIT_FAILURE;
+    }
+#ifndef PLDRAW_HAVE_SVG
+    if (suffix == "svg") {
+        std::cerr << "Error: .svg output needs Qt Svg, which this pldraw was built without" << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+    if (options.width <= 0 || options.height <= 0) {
+        std::cerr << "Error: invalid image size" << std::endl;
+        return EXIT_FAILURE;
+    }
+    QSize size(options.width, options.height);
+    double ready = millis(options.start);
+
+    Clock::time_point start = Clock::now();
+    DisplayListItem list;
+    if (!evaluate_script(options.input, list)) {
+        return EXIT_FAILURE;
+    }
+    double evaluated = millis(start);
+
+    start = Clock::now();
+    bool written = false;
+    if (suffix == "png") {
+        QImage image(size, QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&image);
+        paint_list(painter, list, size, options.scale);
+        painter.end();
+        written = image.save(output, "PNG");
+    }
+#ifdef PLDRAW_HAVE_SVG
+    else {
+        QSvgGenerator generator;
+        generator.setFileName(output);
+        generator.setSize(size);
+        generator.setViewBox(QRect(QPoint(0, 0), size));
+        QPainter painter;
+        if (painter.begin(&generator)) {
+            paint_list(painter, list, size, options.scale);
+            written = painter.end();
+        }
+    }
+#endif
+    if (!written) {
+        std::cerr << "Error: could not write '" << options.output << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.timing) {
+        std::cerr << "startup " << ready << " ms, evaluate " << evaluated << " ms, render and write "
+                  << millis(start) << " ms, total " << millis(options.start) << " ms ("
+                  << list.size() << " graphics)" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
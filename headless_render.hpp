@@ -0,0 +1,24 @@
+#ifndef HEADLESS_RENDER_HPP
+#define HEADLESS_RENDER_HPP
+
+#include <chrono>
+#include <string>
+
+// what pldraw --render draws and where
+struct RenderOptions {
+  std::string input;  // script to evaluate
+  std::string output; // image to write, .png or .svg if built with Qt Svg
+  int width = 800;    // pixels
+  int height = 600;
+  double scale = 0;   // pixels per unit, 0 fits the drawing in the image
+  bool timing = false;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+// evaluate the script of options.input and paint all it draws, or its
+// result if it draws nothing, to options.output without any widget.
+// Needs a QGuiApplication, the offscreen platform will do. Errors are
+// reported on stderr and the exit status is returned
+int render_script(const RenderOptions& options);
+
+#endif
@@ -93,5 +93,33 @@ class TestExecuteFromFile(unittest.TestCase):
 		self.assertNotEqual(retcode, 0)
 		self.assertTrue(output.strip().startswith(b'Error'))
 
+class TestExecuteBatch(unittest.TestCase):
+
+	def test_order(self):
+		args = ' -j 4 /mnt/tests/test3.slp /mnt/tests/test_badeval.slp /mnt/tests/test4.slp'
+		(output, retcode) = pexpect.run(cmd+args, withexitstatus=True, extra_args=args)
+		self.assertNotEqual(retcode, 0)
+		lines = output.strip().splitlines()
+		self.assertEqual(lines[0], b"/mnt/tests/test3.slp: (2)")
+		self.assertTrue(lines[1].startswith(b"/mnt/tests/test_badeval.slp: Error"))
+		self.assertEqual(lines[2], b"/mnt/tests/test4.slp: (-1)")
+
+	def test_timing(self):
+		args = ' --timing /mnt/tests/test3.slp /mnt/tests/test4.slp'
+		(output, retcode) = pexpect.run(cmd+args, withexitstatus=True, extra_args=args)
+		self.assertEqual(retcode, 0)
+		lines = output.strip().splitlines()
+		self.assertTrue(lines[0].startswith(b"/mnt/tests/test3.slp: (2) ("))
+		self.assertTrue(lines[0].endswith(b" ms)"))
+		self.assertTrue(lines[2].startswith(b"2 scripts, 0 failed"))
+
+	def test_share(self):
+		args = ' --share -j 2 /mnt/tests/test3.slp /mnt/tests/test4.slp'
+		(output, retcode) = pexpect.run(cmd+args, withexitstatus=True, extra_args=args)
+		self.assertEqual(retcode, 0)
+		lines = output.strip().splitlines()
+		self.assertEqual(lines[0], b"/mnt/tests/test3.slp: (2)")
+		self.assertEqual(lines[1], b"/mnt/tests/test4.slp: (-1)")
+
 # run the tests
 unittest.main()
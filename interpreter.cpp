@@ -2,231 +2,890 @@
 
 // Constructor
 
-Interpreter::Interpreter() {
+Interpreter::Interpreter() : vm(&sink) {
      //env.reset();  // Initialize environment
 }
 
 // Parse Function
 bool Interpreter::parse(std::istream& expression) noexcept {
     try {
-        std::string input;
-        std::getline(expression, input);
-        std::istringstream input_stream(input);
-
+        // the whole stream is one program
+        source.assign(std::istreambuf_iterator<char>(expression), std::istreambuf_iterator<char>());
+        tokenizeSource();
+    }
+    catch (const std::exception& err) {
+        std::cout << "Unexpected error during parsing: " << err.what() << std::endl;
+        return false;
+    }
 
-        TokenSequenceType tokens = tokenize(input_stream); // tokenize input
-        std::vector<std::string> tokens_vector(tokens.begin(), tokens.end());
+    return parseTokens();
+}
 
-        // check for empty input
-        if (tokens.empty()) {
-            throw InterpreterSemanticError("Error: Empty input");
+// build the AST from tokens, reporting errors like parse
+bool Interpreter::parseTokens() noexcept {
+    try {
+        EvalError error;
+        if (!buildSource(error)) {
+            std::cout << error.message() << std::endl;  // output coresponding error message
+            return false;
         }
+    }
+    catch (const std::exception& err) {
+        std::cout << "Unexpected error during parsing: " << err.what() << std::endl;
+        return false;
+    }
 
-        size_t index = 0;
-        ast = buildAST(tokens_vector, index);  // build AST from tokens
+    return  true;
+}
 
+bool Interpreter::parseNext(FormReader& reader) {
+    if (!reader.next(source)) {
+        return false;
+    }
+    EvalError error;
+    if (!parseSource(error)) {
+        throw InterpreterSemanticError(error.message());
+    }
+    return true;
+}
 
-        if (index != tokens.size()) { // make sure there are no more tokens
-            throw InterpreterSemanticError("Error: Extra tokens after input");
-        }
+bool Interpreter::tryParse(const std::string& program, EvalError& error) {
+    source = program;
+    return parseSource(error);
+}
 
+// build the AST from the text in source
+bool Interpreter::parseSource(EvalError& error) {
+    tokenizeSource();
+    return buildSource(error);
+}
+
+void Interpreter::tokenizeSource() {
+    tokens.clear();
+    tokenize(source.data(), source.size(), tokens); // tokenize input
+}
 
+// build the AST from the tokens of source
+bool Interpreter::buildSource(EvalError& error) {
+    unbuilt = false;
+    paren = false;
+    compiled = false;
+    ast.clear();
+
+    // check for empty input
+    if (tokens.empty()) {
+        return error.fail(SyntaxError, "Error: Empty input");
     }
-    catch (const InterpreterSemanticError& err) {
-        std::cout << err.what() << std::endl;  // output coresponding error message
-        return  false;
+
+    // a list is one node for its two paren tokens, an atom one node, so
+    // the nodes are known before building and the Ast grows once
+    size_t closes = 0;
+    for (const Token& token : tokens) {
+        closes += token.kind == CloseToken;
     }
-    catch (const std::exception& err) {
-        std::cout << "Unexpected error during parsing: " << err.what() << std::endl;
+    ast.reserve(tokens.size() - closes);
+
+    size_t index = 0;
+    pending.clear();
+    if (!buildAST(source, tokens, index, error)) {  // build AST from tokens
+        ast.clear(); // drop the partial AST
         return false;
     }
-
-    return  true;
+    if (index != tokens.size()) { // make sure there are no more tokens
+        ast.clear();
+        return error.fail(SyntaxError, "Error: Extra tokens after input");
+    }
+    resolveProcedures();
+    foldConstants();
+    inferTypes();
+    return true;
 }
 
-Expression Interpreter::buildAST(const std::vector<std::string>& tokens, size_t& index) {
+// lists are built iteratively, marks holds the pending offset of each open list
+bool Interpreter::buildAST(const std::string& source, const TokenViewSequenceType& tokens, size_t& index, EvalError& error) {
     if (index >= tokens.size()) {
-        throw InterpreterSemanticError("Error: Unexpected end of input");
+        return error.fail(SyntaxError, "Error: Unexpected end of input");
     }
 
-    if (tokens[index] == "(") { // checking for open paren
-        paren = true;
-        ++index;  // skip the opening parenthesis in index
+    marks.clear();
+    for (;;) {
+        std::uint32_t node;
+        const Token& token = tokens[index];
 
-        if (index >= tokens.size() || tokens[index] == ")") {        // check if expression is empty
-            throw InterpreterSemanticError("Error: Empty or invalid expression");
-        }
+        if (token.kind == OpenToken) { // checking for open paren
+            paren = true;
+            ++index;  // skip the opening parenthesis in index
 
-        std::vector<Expression> subExpressions;
-        while (index < tokens.size() && tokens[index] != ")") { // get all sub-expressions until we until )
-            subExpressions.push_back(buildAST(tokens, index));  // recursive call to handle inside expressions
-        }
+            if (index >= tokens.size() || tokens[index].kind == CloseToken) {        // check if expression is empty
+                return error.fail(SyntaxError, "Error: Empty or invalid expression");
+            }
+            if (marks.size() >= depthLimit) {
+                return error.fail(SyntaxError, "Error: Expression nested too deeply");
+            }
 
-        if (index >= tokens.size() || tokens[index] != ")") {
-            throw InterpreterSemanticError("Error: Mismatched parentheses");
+            // sub-expressions are collected on the pending stack above mark
+            marks.push_back(pending.size());
+            continue;
         }
 
-        ++index;  // skip the close parenthesis in index
+        Atom atom;
+        if (token.kind == AtomToken && token_to_atom(source.data() + token.offset, token.length, atom)) {
+            ++index;
 
-        if (subExpressions.empty()) {
-            throw InterpreterSemanticError("Error: No operands or operator in expression");
+            if (atom.type == SymbolType && !paren) {
+                return error.fail(InvalidSymbolError, atom.value.sym_value.id);
+            }
+            if (atom.type != NumberType && atom.type != BooleanType && atom.type != SymbolType) {
+                return error.fail(SyntaxError, "Error: Unknown atom type");
+            }
+            node = ast.add(atom, nullptr, 0);
+        }
+        else {
+            return error.fail(InvalidTokenError, source.substr(token.offset, token.length));
         }
 
-        // The first expression in the list is the operator (head)
-        Expression exp;
-        exp.head = subExpressions.back().head;  // assign operator to the head
-        subExpressions.erase(subExpressions.end() - 1);  // Remove the operator
+        // close every list that node completes
+        for (;;) {
+            if (marks.empty()) {
+                return true;
+            }
+            pending.push_back(node);
 
-        // rest are operands (tail)
-        exp.tail = subExpressions;
+            if (index < tokens.size() && tokens[index].kind != CloseToken) { // more sub-expressions until )
+                break;
+            }
+            if (index >= tokens.size()) {
+                return error.fail(SyntaxError, "Error: Mismatched parentheses");
+            }
+
+            ++index;  // skip the close parenthesis in index
+
+            size_t mark = marks.back();
+            marks.pop_back();
+            if (pending.size() == mark) {
+                return error.fail(SyntaxError, "Error: No operands or operator in expression");
+            }
+
+            // The last expression in the list is the operator (head), rest are operands (tail)
+            const Atom head = ast.nodes[pending.back()].head;
+
+            // Check if the head is a valid keyword
+            if (head.type == SymbolType && !env.isKeyword(head.value.sym_value)) {
+                return error.fail(UnrecognizedKeywordError, head.value.sym_value.id);
+            }
 
-        // Check if the head is a valid keyword
-        if (exp.head.type == SymbolType && !env.isKeyword(exp.head.value.sym_value)) {
-            throw InterpreterSemanticError("Error: Unrecognized keyword '" + exp.head.value.sym_value + "'");
+            std::uint32_t count = static_cast<std::uint32_t>(pending.size() - mark - 1);
+            node = ast.add(head, pending.data() + mark, count);
+            pending.resize(mark);
         }
+    }
+}
 
-        return exp;
+// point each call node at the builtin its operator is bound to
+void Interpreter::resolveProcedures() {
+    for (AstNode& node : ast.nodes) {
+        if (node.count != 0 && node.head.type == SymbolType) {
+            node.proc = env.getProcedure(node.head.value.sym_value);
+        }
     }
+    resolved = env.version();
+}
 
-    Expression exp;
-    Atom atom;
-    if (token_to_atom(tokens[index], atom)) {
-        ++index;
+// true if the builtin bound to op always gives the same result for the same
+// arguments and its result is small. range and linspace are pure but left to
+// eval: folded, a list in a branch never taken would still be built
+static bool is_pure(const Symbol& op) {
+    switch (op.id) {
+    case AddId: case SubtractId: case MultiplyId: case DivideId: case SqrtId: case Log2Id:
+    case LessId: case LessEqualId: case GreaterId: case GreaterEqualId: case EqualId:
+    case AndId: case OrId: case NotId:
+    case SinId: case CosId: case ArctanId:
+    case PointId: case LineId: case ArcId: case RectId: case FillRectId: case EllipseId:
+        return true;
+    default:
+        return false;
+    }
+}
 
-        if (atom.type == NumberType || atom.type == BooleanType) {
-            return Expression(atom);
-        }
-        if (atom.type == SymbolType) {
-            if (!paren) {
-                throw InterpreterSemanticError("Error: Invalid symbol '" + atom.value.sym_value + "'");
+// replace every call of a pure builtin on constant operands with its result.
+// Nodes are in postfix order, so operands are folded before their call.
+// A call that fails is left as it is to raise the error at eval time
+void Interpreter::foldConstants() {
+    // pi is a constant unless the host rebinds it, which changes env.version()
+    const Symbol pi = Symbol::fromId(PiId);
+    bool pi_constant = env.isDefined(pi) && !env.isProcedure(pi);
+
+    // collect the values of the operands of node into args, false if one is not constant
+    std::vector<Atom> args;
+    Atom result;
+    EvalError error;
+    auto constant_operands = [&](const AstNode& node) {
+        args.clear();
+        for (std::uint32_t i = 0; i < node.count; ++i) {
+            const AstNode& operand = ast.child(node, i);
+            if (operand.count != 0) {
+                return false;
+            }
+            if (operand.head.type != SymbolType) {
+                args.push_back(operand.head);
+            }
+            else if (operand.head.value.sym_value == pi && pi_constant) {
+                args.push_back(env.get(pi).head);
             }
+            else {
+                return false;
+            }
+        }
+        return true;
+    };
 
-            return Expression(atom); // Return the symbol expression
+    for (std::uint32_t index = 0; index < ast.nodes.size(); ++index) {
+        const AstNode& node = ast.nodes[index];
+        if (node.count == 0) {
+            continue;
         }
 
-        throw InterpreterSemanticError("Error: Unknown atom type");
+        if (node.proc != nullptr && is_pure(node.head.value.sym_value) && constant_operands(node)
+            && node.proc(args, result, error)) {
+            ast.replace(index, result);
+            continue;
+        }
+        ast.rehash(index); // its operands may have been folded
+    }
+}
 
+// prove the type of each node from its literals, the values env binds and
+// the types the builtins return, in postfix order so the operands of a
+// call are typed before it. Calls whose argument types are proved go to
+// their builtin without its type checks; everything else keeps the checks,
+// so errors are the same. A symbol the AST defines is typed only after
+// its last define, with the type of every value it holds, before and after
+void Interpreter::inferTypes() {
+    Atom value;
+    EvalError unbound;
+    definitions.clear();
+    for (const AstNode& node : ast.nodes) {
+        if (node.count == 2 && node.head.type == SymbolType && node.head.value.sym_value.id == DefineId) {
+            const AstNode& target = ast.child(node, 0);
+            if (target.count == 0 && target.head.type == SymbolType) {
+                Definition& definition = definitions[target.head.value.sym_value.id];
+                if (definition.pending++ == 0 && env.get(target.head.value.sym_value, value, unbound)) {
+                    definition.bound = true; // its value before the define
+                    definition.type = value.type;
+                }
+            }
+        }
     }
-    throw InterpreterSemanticError("Error: Invalid token '" + tokens[index] + "'");
 
+    for (AstNode& node : ast.nodes) {
+        node.type = NoneType;
+        if (node.count == 0) {
+            if (node.head.type != SymbolType) { // a literal or folded constant
+                node.type = node.head.type;
+                continue;
+            }
+            const Symbol& symbol = node.head.value.sym_value;
+            auto defined = definitions.find(symbol.id);
+            if (defined == definitions.end()) {
+                node.type = env.get(symbol, value, unbound) ? value.type : NoneType;
+            }
+            else if (defined->second.pending == 0) {
+                node.type = defined->second.type;
+            }
+            continue;
+        }
+        if (node.head.type != SymbolType) {
+            continue;
+        }
 
+        const Symbol& op = node.head.value.sym_value;
+        if (op.id == DefineId) {
+            if (node.count != 2) {
+                continue;
+            }
+            node.type = ast.child(node, 1).type; // define gives the value
+            const AstNode& target = ast.child(node, 0);
+            if (target.count == 0 && target.head.type == SymbolType) {
+                Definition& definition = definitions[target.head.value.sym_value.id];
+                definition.type = !definition.bound || definition.type == node.type ? node.type : NoneType;
+                definition.bound = true;
+                --definition.pending;
+            }
+        }
+        else if (op.id == BeginId) {
+            node.type = ast.child(node, node.count - 1).type;
+        }
+        else if (op.id == IfId) {
+            if (node.count == 3 && ast.child(node, 1).type == ast.child(node, 2).type) {
+                node.type = ast.child(node, 1).type;
+            }
+        }
+        else if (node.proc != nullptr) {
+            types.clear();
+            for (std::uint32_t i = 0; i < node.count; ++i) {
+                types.push_back(ast.child(node, i).type);
+            }
+            Procedure unchecked;
+            node.type = env.callType(op, types.data(), node.count, unchecked);
+            if (unchecked != nullptr) {
+                node.proc = unchecked;
+            }
+        }
+    }
 }
 
 // Evaluate Function
 Expression Interpreter::eval() {
-    return evalExpression(ast);
+    Atom result;
+    EvalError error;
+    if (!evaluate(result, error)) {
+        throw InterpreterSemanticError(error.message());
+    }
+    return Expression(result);
 }
 
+EvalResult Interpreter::tryEval() {
+    EvalResult result;
+    Atom value;
+    if (evaluate(value, result.error)) {
+        result.value = Expression(value);
+    }
+    return result;
+}
 
-Expression Interpreter::evalExpression(const Expression& exp) {
-    if (exp.tail.empty()) {
-
-        if (exp.head.type == SymbolType) {// check if number, boolean, or symbol      
-            return env.get(exp.head.value.sym_value); // Look up the symbol in the env
+// evaluate the AST into result, or describe the error that stopped it
+bool Interpreter::evaluate(Atom& result, EvalError& error) {
+    if (unbuilt && !parseSource(error)) { // a cached input evaluated again
+        return false;
+    }
+    if (ast.empty()) {
+        result = Atom();
+        return true;
+    }
+    if (resolved != env.version() && !parseSource(error)) { // fold again with the new bindings
+        return false;
+    }
+    sink.clear();
+    bool ok;
+    const AstNode& root = ast.nodes[ast.root()];
+    if (mode == BytecodeMode) { // compile once per parse
+        if (!compiled) {
+            compile(ast, ast.root(), env, program);
+            compiled = true;
         }
+        ok = vm.run(program, env, result, error);
+    }
+    else if (pool && root.count != 0 && root.head.type == SymbolType && root.head.value.sym_value.id == BeginId) {
+        ok = evalParallel(root, result, error);
+    }
+    else {
+        ok = evalExpression(root, stack, result, error);
+    }
+    sink.flush(); // also what was drawn before an error
+    return ok;
+}
 
+void Interpreter::setEvalMode(EvalMode mode) {
+    this->mode = mode;
+}
 
-        return exp; // Returning the expression as is (number, boolean)
+EvalMode Interpreter::evalMode() const {
+    return mode;
+}
 
-    }
 
-    // last operand should be the head
-    if (exp.head.type != SymbolType) {
-        throw InterpreterSemanticError("Error: Operator must be a symbol");
-    }
+// evaluation runs on explicit stacks: each frame is a node being evaluated,
+// step counts its children done so far, the values of evaluated children
+// are on values above base
+bool Interpreter::evalExpression(const AstNode& root, EvalStack& state, Atom& result, EvalError& error) {
+    std::vector<EvalFrame>& frames = state.frames;
+    std::vector<Atom>& values = state.values;
+    std::vector<Atom>& args = state.args;
 
-    std::string op = exp.head.value.sym_value;
+    frames.clear();
+    values.clear();
+    frames.push_back(EvalFrame{ &root, 0, 0 });
+
+    while (!frames.empty()) {
+        if (frames.size() > depthLimit) {
+            return error.fail(DepthError, "Error: Expression nested too deeply");
+        }
 
-    if (op == "define") { // define special form
+        EvalFrame& frame = frames.back();
+        const AstNode& exp = *frame.node;
 
-        if (exp.tail.size() != 2) {
-            throw InterpreterSemanticError("Error: 'define' expects exactly two arguments");
+        if (exp.count == 0) {
+            if (exp.head.type == SymbolType) {// check if number, boolean, or symbol
+                values.emplace_back();
+                if (!lookup(state, exp.head.value.sym_value, values.back(), error)) { // Look up the symbol in the env
+                    return false;
+                }
+            }
+            else {
+                values.push_back(exp.head); // Returning the expression as is (number, boolean)
+            }
+            frames.pop_back();
+            continue;
         }
 
-        Expression symbolExp = exp.tail[0].head.value.sym_value;
-        Expression valueExp = evalExpression(exp.tail[1]);
-        if (symbolExp.head.type != SymbolType) {// should be a symbol
-            throw InterpreterSemanticError("Error: 'define' requires a symbol as the first argument");
+        // last operand should be the head
+        if (exp.head.type != SymbolType) {
+            return error.fail(SpecialFormError, "Error: Operator must be a symbol");
         }
 
-        std::string symbol = symbolExp.head.value.sym_value;
-        if (env.isKeyword(symbol)) {
-            throw InterpreterSemanticError("Error: Invalid symbol, symbol is a keyword");
+        const Symbol& op = exp.head.value.sym_value;
+        std::uint32_t step = frame.step++;
+
+        if (op.id == DefineId) { // define special form
+            if (exp.count != 2) {
+                return error.fail(SpecialFormError, "Error: 'define' expects exactly two arguments");
+            }
+
+            const AstNode& valueNode = ast.child(exp, 1);
+            if (step == 0) { // evaluate the value first
+                frames.push_back(EvalFrame{ &valueNode, 0, values.size() });
+                continue;
+            }
+
+            const AstNode& symbolNode = ast.child(exp, 0);
+            if (symbolNode.head.type != SymbolType) {// should be a symbol
+                return error.fail(SpecialFormError, "Error: 'define' requires a symbol as the first argument");
+            }
+
+            const Symbol& symbol = symbolNode.head.value.sym_value;
+            if (env.isKeyword(symbol)) {
+                return error.fail(SpecialFormError, "Error: Invalid symbol, symbol is a keyword");
+            }
+
+            if (valueNode.head.type == SymbolType && valueNode.count == 0 && !isDefined(state, valueNode.head.value.sym_value)) {// check for (define x 10) error
+                return error.fail(SpecialFormError, "Error: Incorrect usage of 'define'. Correct syntax is '(symbol value define)'");
+            }
+
+            if (state.deferred) { // committed when the evaluations beside it are done
+                state.locals.emplace_back(symbol.id, values.back());
+            }
+            else {
+                env.define(symbol, Expression(values.back()));// add map to the env, the value is the result
+            }
+            frames.pop_back();
+            continue;
         }
 
-        if (exp.tail[1].head.type == SymbolType && exp.tail[1].tail.empty() && !(env.isDefined(exp.tail[1].head.value.sym_value))) {// check for (define x 10) error
-            throw InterpreterSemanticError("Error: Incorrect usage of 'define'. Correct syntax is '(symbol value define)'");
+        if (op.id == BeginId) {// begin special form, keep only the last value
+            if (step != 0) {
+                if (step == exp.count) {
+                    frames.pop_back();
+                    continue;
+                }
+                values.pop_back();
+            }
+            frames.push_back(EvalFrame{ &ast.child(exp, step), 0, values.size() });
+            continue;
         }
 
+        if (op.id == IfId) {// if special form
+            if (exp.count != 3) {
+                return error.fail(SpecialFormError, "Error: 'if' expects exactly three arguments");
+            }
 
-        Expression valueResult = evalExpression(valueExp);// evaluate second expression
+            if (step == 0) { // eval first expression (condition)
+                frames.push_back(EvalFrame{ &ast.child(exp, 0), 0, values.size() });
+                continue;
+            }
 
-        env.define(symbol, valueResult);// add map to the env
+            const Atom condition = values.back();
+            values.pop_back();
+            if (condition.type != BooleanType) {// check if condition is a boolean
+                return error.fail(SpecialFormError, "Error: 'if' condition must be a boolean");
+            }
 
-        return valueExp;
-    }
-    if (op == "begin") {// begin special form
+            // the chosen branch replaces the if
+            frame.node = &ast.child(exp, condition.value.bool_value ? 1 : 2);
+            frame.step = 0;
+            continue;
+        }
 
-        if (exp.tail.empty()) {
-            throw InterpreterSemanticError("Error: 'begin' expects at least one argument");
+        bool direct = exp.proc != nullptr && resolved == env.version(); // builtin resolved at parse
+        if (step == 0 && !direct && !env.isProcedure(op)) {// check if the operator is a recognized procedure
+            return error.fail(UnknownProcedureError, op.id);
         }
 
-        Expression result;
-        for (const auto& expr : exp.tail) {
-            result = evalExpression(expr);
+        if (step < exp.count) { // evaluate the operands to Atoms for the procedure call
+            frames.push_back(EvalFrame{ &ast.child(exp, step), 0, values.size() });
+            continue;
         }
-        return result;  // return result from last expression
-    }
-    if (op == "if") {// if special form
 
-        if (exp.tail.size() != 3) {
-            throw InterpreterSemanticError("Error: 'if' expects exactly three arguments");
+        args.assign(values.begin() + frame.base, values.end());
+        values.resize(frame.base);
+        values.emplace_back();
+        bool called = direct ? exp.proc(args, values.back(), error)
+            : env.call(op, args, values.back(), error); // call procedure with the arguments
+        if (!called) {
+            return false;
         }
+        if (op.id == DrawId && (direct || env.getProcedure(op) != nullptr)) { // the builtin draw
+            if (state.deferred) {
+                state.drawn.insert(state.drawn.end(), args.begin(), args.end());
+            }
+            else {
+                sink.draw(args.data(), args.size());
+            }
+        }
+        frames.pop_back();
+    }
 
-        Expression condition = evalExpression(exp.tail[0]);// eval first expression (condition)
+    result = values.back();
+    return true;
+}
 
-        if (condition.head.type != BooleanType) {// check if condition is a boolean
-            throw InterpreterSemanticError("Error: 'if' condition must be a boolean");
+// the value of sym, seen by an evaluation with its own defines first
+bool Interpreter::lookup(const EvalStack& state, const Symbol& sym, Atom& value, EvalError& error) const {
+    if (state.deferred) {
+        for (std::size_t i = state.locals.size(); i > state.base; --i) {
+            if (state.locals[i - 1].first == sym.id) {
+                value = state.locals[i - 1].second;
+                return true;
+            }
         }
+    }
+    return env.get(sym, value, error);
+}
+
+bool Interpreter::isDefined(const EvalStack& state, const Symbol& sym) const {
+    if (state.deferred) {
+        for (std::size_t i = state.base; i < state.locals.size(); ++i) {
+            if (state.locals[i].first == sym.id) {
+                return true;
+            }
+        }
+    }
+    return env.isDefined(sym);
+}
+
+void Interpreter::analyze(const AstNode& exp, Access& access) {
+    access.reads.clear();
+    access.writes.clear();
+    access.barrier = false;
 
-        if (condition.head.value.bool_value) {// eval second expression
-            return evalExpression(exp.tail[1]);
+    walk.clear();
+    walk.push_back(&exp);
+    while (!walk.empty()) {
+        const AstNode& node = *walk.back();
+        walk.pop_back();
 
+        if (node.count == 0) {
+            if (node.head.type == SymbolType) {
+                access.reads.push_back(node.head.value.sym_value.id);
+            }
+            continue;
         }
-        // eval third expression
-        return evalExpression(exp.tail[2]);
 
+        std::uint32_t first = 0;
+        if (node.head.type == SymbolType) {
+            const Symbol& op = node.head.value.sym_value;
+            const AstNode& target = ast.child(node, 0);
+            if (op.id == DefineId && node.count == 2 && target.count == 0 && target.head.type == SymbolType) {
+                access.writes.push_back(target.head.value.sym_value.id);
+                // rebinding a procedure changes env.version() for everyone
+                access.barrier = access.barrier || env.isProcedure(target.head.value.sym_value);
+                first = 1;
+            }
+            else if (op.id != DefineId && op.id != BeginId && op.id != IfId && node.proc == nullptr) {
+                access.barrier = true; // a procedure the host defined, or an unknown one
+            }
+        }
+        for (std::uint32_t i = first; i < node.count; ++i) {
+            walk.push_back(&ast.child(node, i));
+        }
+    }
+}
 
+// split the children of root into waves of children that neither read
+// nor define a symbol an earlier child of the wave defines, and evaluate
+// the waves in order. A child calling a procedure of the host is a wave
+// of its own
+bool Interpreter::evalParallel(const AstNode& root, Atom& result, EvalError& error) {
+    accesses.resize(root.count);
+    for (std::uint32_t i = 0; i < root.count; ++i) {
+        analyze(ast.child(root, i), accesses[i]);
     }
 
-    if (env.isProcedure(op)) {// check if the operator is a recognized procedure
+    std::unordered_set<SymbolId> written;
+    std::size_t first = 0;
+    while (first < root.count) {
+        std::size_t last = first + 1;
+        written.clear();
+        written.insert(accesses[first].writes.begin(), accesses[first].writes.end());
+        while (!accesses[first].barrier && last < root.count) {
+            const Access& access = accesses[last];
+            bool depends = access.barrier;
+            for (SymbolId id : access.reads) {
+                depends = depends || written.count(id) != 0;
+            }
+            for (SymbolId id : access.writes) {
+                depends = depends || written.count(id) != 0;
+            }
+            if (depends) {
+                break;
+            }
+            written.insert(access.writes.begin(), access.writes.end());
+            ++last;
+        }
 
-        auto procResult = env.getResult(op); // get procedure from the environment
+        if (!evalWave(root, first, last, result, error)) {
+            return false;
+        }
+        first = last;
+    }
+    return true;
+}
 
-        std::vector<Expression> evaluated_args;
+// evaluate children [first, last) of root, which are independent. Each
+// child is evaluated deferred on a pool worker, then the defines of the
+// children are committed in order up to the first that failed
+bool Interpreter::evalWave(const AstNode& root, std::size_t first, std::size_t last, Atom& result, EvalError& error) {
+    std::size_t size = last - first;
+    if (size < MinParallelChildren) {
+        for (std::size_t i = first; i < last; ++i) {
+            if (!evalExpression(ast.child(root, static_cast<std::uint32_t>(i)), stack, result, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (EvalStack& worker : stacks) {
+        worker.deferred = true;
+        worker.locals.clear();
+        worker.drawn.clear();
+    }
+    outcomes.assign(size, Outcome());
+
+    // a few chunks per worker so uneven children balance out
+    std::size_t chunks = std::min(size, pool->size() * 4);
+    pool->run(chunks, [&](std::size_t worker, std::size_t chunk) {
+        EvalStack& state = stacks[worker];
+        for (std::size_t i = size * chunk / chunks; i < size * (chunk + 1) / chunks; ++i) {
+            Outcome& outcome = outcomes[i];
+            outcome.stack = worker;
+            outcome.begin = state.base = state.locals.size();
+            outcome.first = state.drawn.size();
+            outcome.ok = evalExpression(ast.child(root, static_cast<std::uint32_t>(first + i)), state, outcome.value, outcome.error);
+            outcome.end = state.locals.size();
+            outcome.last = state.drawn.size();
+            if (!outcome.ok) { // the children after it are never committed
+                break;
+            }
+        }
+    });
 
-        for (const auto& operand : exp.tail) {
-            evaluated_args.push_back(evalExpression(operand));
+    for (const Outcome& outcome : outcomes) {
+        const EvalStack& state = stacks[outcome.stack];
+        for (std::size_t i = outcome.begin; i < outcome.end; ++i) {
+            env.define(Symbol::fromId(state.locals[i].first), Expression(state.locals[i].second));
         }
-        // convert evaluated expressions to Atoms for the procedure call
-        std::vector<Atom> argAtoms;
-        for (const auto& arg : evaluated_args) {
-            argAtoms.push_back(arg.head);  // use head of each evaluated expression
+        sink.draw(state.drawn.data() + outcome.first, outcome.last - outcome.first);
+        if (!outcome.ok) {
+            error = outcome.error;
+            return false;
         }
+    }
+    result = outcomes.back().value;
+    return true;
+}
 
-        return procResult.proc(env, argAtoms); // call procedure with the arguments
+void Interpreter::setThreads(std::size_t threads) {
+    if (threads <= 1) {
+        pool.reset();
+        stacks.clear();
+        return;
     }
+    pool.reset(new ThreadPool(threads));
+    stacks.assign(threads, EvalStack());
+}
 
-    throw InterpreterSemanticError("Error: Unknown procedure '" + op + "'");
+std::size_t Interpreter::threads() const {
+    return pool ? pool->size() : 1;
+}
 
+GeometrySink& Interpreter::geometry() {
+    return sink;
+}
 
+void Interpreter::setMaxDepth(std::size_t depth) {
+    depthLimit = depth;
+}
+
+std::size_t Interpreter::maxDepth() const {
+    return depthLimit;
+}
+
+void Interpreter::setSharedSubtrees(bool enabled) {
+    ast.setSharing(enabled);
 }
 
 // parse and eval the input string (for pldraw)
 Expression Interpreter::parseAndEvaluate(const std::string &input) {
-    std::istringstream stringS(input);
-    if (!parse(stringS)) {
+    EvalResult result = tryParseAndEvaluate(input);
+    if (result.error.parseError()) { // reported like parse
+        std::cout << result.error.message() << std::endl;
         throw InterpreterSemanticError("Parsing failed");
     }
-    return eval();
+    if (!result.ok()) {
+        throw InterpreterSemanticError(result.error.message());
+    }
+    return result.value;
+}
+
+EvalResult Interpreter::tryParseAndEvaluate(const std::string& input) {
+    EvalResult result;
+    sink.clear(); // also when the result is cached
+    if (caching) { // input entered before, found without tokenizing
+        auto seen = inputs.find(std::hash<std::string>()(input));
+        if (seen != inputs.end()) {
+            auto cached = cache.find(seen->second);
+            if (cached != cache.end() && cached->second.text == input && isCurrent(cached->second)) {
+                ++hits;
+                source = input; // the current program, built if evaluated again
+                unbuilt = true;
+                result.value = cached->second.result;
+                return result;
+            }
+        }
+    }
+
+    source = input;
+    tokenizeSource();
+
+    std::uint64_t hash = 0;
+    if (caching) { // the same tokens entered with other spacing or comments
+        hash = hashTokens();
+        auto cached = cache.find(hash);
+        if (cached != cache.end() && isCurrent(cached->second) && matchesTokens(cached->second.text)) {
+            ++hits;
+            unbuilt = true;
+            result.value = cached->second.result;
+            return result;
+        }
+        ++misses;
+    }
+
+    Atom value;
+    if (!buildSource(result.error) || !evaluate(value, result.error)) {
+        return result;
+    }
+    result.value = Expression(value);
+    if (caching && cacheable()) {
+        storeResult(hash, result.value);
+    }
+    return result;
+}
+
+// FNV-1a over the token texts, each followed by a separator so whitespace
+// and comments between tokens do not change the hash
+std::uint64_t Interpreter::hashTokens() const {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const Token& token : tokens) {
+        const char* text = source.data() + token.offset;
+        for (std::size_t i = 0; i < token.length; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(text[i])) * 1099511628211ULL;
+        }
+        hash = (hash ^ ' ') * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// true if nothing entry read has changed since it was stored
+bool Interpreter::isCurrent(const CacheEntry& entry) const {
+    if (entry.version != env.version()) {
+        return false;
+    }
+    for (const auto& read : entry.reads) {
+        if (env.stamp(Symbol::fromId(read.first)) != read.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// true if text has the same tokens as source, only tokenized on a hit
+// of the hash of the tokens
+bool Interpreter::matchesTokens(const std::string& text) {
+    entryTokens.clear();
+    tokenize(text.data(), text.size(), entryTokens);
+    if (entryTokens.size() != tokens.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const Token& token = tokens[i];
+        const Token& entryToken = entryTokens[i];
+        if (entryToken.length != token.length || text.compare(entryToken.offset, token.length, source, token.offset, token.length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a form can be cached if evaluating it has no effect besides its result:
+// it defines nothing, draws nothing and calls only builtins
+bool Interpreter::cacheable() const {
+    for (const AstNode& node : ast.nodes) {
+        if (node.count == 0 || node.head.type != SymbolType) {
+            continue;
+        }
+        SymbolId op = node.head.value.sym_value.id;
+        if (op == DefineId || op == DrawId || (op != BeginId && op != IfId && node.proc == nullptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Interpreter::storeResult(std::uint64_t hash, const Expression& result) {
+    if (cache.size() >= MaxCacheEntries) {
+        clearCache();
+    }
+
+    CacheEntry& entry = cache[hash];
+    entry.text = source;
+    entry.result = result;
+    entry.version = env.version();
+
+    // symbols read by the form, with the stamps of their bindings
+    entry.reads.clear();
+    for (const AstNode& node : ast.nodes) {
+        if (node.count == 0 && node.head.type == SymbolType) {
+            SymbolId id = node.head.value.sym_value.id;
+            entry.reads.push_back(std::make_pair(id, env.stamp(Symbol::fromId(id))));
+        }
+    }
+    std::sort(entry.reads.begin(), entry.reads.end());
+    entry.reads.erase(std::unique(entry.reads.begin(), entry.reads.end()), entry.reads.end());
+
+    // inputs may still hold the hashes of texts the entry was stored for
+    // before, those miss on comparing the text
+    if (inputs.size() >= MaxCacheEntries) {
+        inputs.clear();
+    }
+    inputs[std::hash<std::string>()(source)] = hash;
+}
+
+void Interpreter::setResultCache(bool enabled) {
+    caching = enabled;
+    if (!enabled) {
+        clearCache();
+    }
+}
+
+void Interpreter::clearCache() {
+    cache.clear();
+    inputs.clear();
+}
+
+std::size_t Interpreter::cacheHits() const {
+    return hits;
+}
+
+std::size_t Interpreter::cacheMisses() const {
+    return misses;
 }
\ No newline at end of file
@@ -4,17 +4,31 @@
 // system includes
 // TODO: Include C++ standard library headers as needed
 #include <sstream>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <algorithm>
+#include <memory>
 
 // module includes
 #include "expression.hpp"
+#include "ast.hpp"
+#include "bytecode.hpp"
 #include "environment.hpp"
+#include "eval_error.hpp"
+#include "geometry_sink.hpp"
+#include "thread_pool.hpp"
 // TODO: Include firther custom header files if need
 #include "tokenizer.hpp"
+#include "form_reader.hpp"
 #include "interpreter_semantic_error.hpp"
 
+// how eval runs the AST, walking the tree or compiling it to bytecode
+enum EvalMode { TreeWalkMode, BytecodeMode };
+
 // Interpreter has
 // Environment, which starts at a default
 // parse method, builds an internal AST
@@ -26,17 +40,164 @@ public:
 	bool parse(std::istream& expression) noexcept;
 	Expression eval();
 
+	// parse the next top-level form of reader, returns false at end of input
+	// and throws InterpreterSemanticError if the form does not parse
+	bool parseNext(FormReader& reader);
+
 	Expression parseAndEvaluate(const std::string& input);
 
+	// the same without exceptions: invalid input gives an error code and
+	// nothing is printed. The message is only formatted if asked for, so
+	// rejecting input is about as cheap as evaluating it
+	bool tryParse(const std::string& program, EvalError& error);
+	EvalResult tryEval();
+	EvalResult tryParseAndEvaluate(const std::string& input);
+
+	// parseAndEvaluate keeps the results of forms that define nothing, keyed
+	// by their tokens. Entering a form again returns its cached result
+	// without evaluating while every symbol it reads keeps its binding.
+	// Off by default, the REPLs turn it on
+	void setResultCache(bool enabled);
+	void clearCache();
+	std::size_t cacheHits() const;
+	std::size_t cacheMisses() const;
+
+	void setEvalMode(EvalMode mode);
+	EvalMode evalMode() const;
+
+	// deepest list nesting parse and eval accept, deeper input raises
+	// InterpreterSemanticError instead of exhausting memory
+	void setMaxDepth(std::size_t depth);
+	std::size_t maxDepth() const;
+
+	// hash-cons the AST of the next parse, equal subtrees are stored once
+	void setSharedSubtrees(bool enabled);
+
+	// evaluate the children of a top-level begin on this many threads in
+	// TreeWalkMode, 1 runs everything on the calling thread. Children run
+	// side by side unless one reads or redefines a symbol an earlier one
+	// defines, or calls a procedure the host defined; the result, errors,
+	// defines and drawn graphics are those of evaluating them in order
+	void setThreads(std::size_t threads);
+	std::size_t threads() const;
+
+	// the graphics draw is called with go to this sink in the order they
+	// are drawn, what is left of a batch is flushed when eval returns.
+	// Without a handler it holds the graphics of the last evaluation
+	GeometrySink& geometry();
+
 private:
 
 	Environment env;
-	Expression ast;
-	std::vector<std::string> tokens;
-	Expression buildAST(const std::vector<std::string>& tokens, size_t& index);
-	Expression evalExpression(const Expression& exp);
+	Ast ast;
+	std::string source; // text of the last parse, tokens index into it
+	bool unbuilt = false; // source was a cache hit, the AST is of an earlier parse
+	TokenViewSequenceType tokens;
+	std::vector<std::uint32_t> pending; // nodes of the lists being built
+	std::vector<size_t> marks;          // offset in pending of each open list
+	bool parseSource(EvalError& error);
+	void tokenizeSource();
+	bool buildSource(EvalError& error);
+	bool parseTokens() noexcept;
+	bool buildAST(const std::string& source, const TokenViewSequenceType& tokens, size_t& index, EvalError& error);
+	bool evaluate(Atom& result, EvalError& error);
+	void resolveProcedures();
+	void foldConstants();
+	void inferTypes();
+	std::uint64_t resolved = 0; // Environment::version() the AstNode procs were resolved at
 	bool paren = false;
 
+	// a symbol the AST defines, with its defines not yet inferred and the
+	// type of every value it held so far, NoneType if they differ
+	struct Definition {
+		std::uint32_t pending = 0;
+		bool bound = false;
+		Type type = NoneType;
+	};
+	std::unordered_map<SymbolId, Definition> definitions;
+	std::vector<Type> types; // argument types of a call being inferred
+
+	// a node being evaluated, step children done, their values above base
+	struct EvalFrame {
+		const AstNode* node;
+		std::uint32_t step;
+		std::size_t base;
+	};
+
+	// the stacks of one evaluation. A deferred evaluation runs beside
+	// others, so it only reads env and keeps its defines in locals, from
+	// offset base on, until they are committed in order
+	struct EvalStack {
+		std::vector<EvalFrame> frames;
+		std::vector<Atom> values;
+		std::vector<Atom> args;
+		bool deferred = false;
+		std::vector<std::pair<SymbolId, Atom>> locals;
+		std::vector<Atom> drawn; // graphics drawn, committed with locals
+		std::size_t base = 0;
+	};
+	EvalStack stack;
+	std::size_t depthLimit = 16 * 1024 * 1024;
+	GeometrySink sink;
+	bool evalExpression(const AstNode& exp, EvalStack& state, Atom& result, EvalError& error);
+	bool lookup(const EvalStack& state, const Symbol& sym, Atom& value, EvalError& error) const;
+	bool isDefined(const EvalStack& state, const Symbol& sym) const;
+
+	// the symbols a subtree reads and defines, barrier if it calls a
+	// procedure whose effects are unknown or rebinds a procedure
+	struct Access {
+		std::vector<SymbolId> reads;
+		std::vector<SymbolId> writes;
+		bool barrier;
+	};
+	// the result of a child evaluated deferred, its defines are
+	// stacks[stack].locals[begin, end) and its graphics
+	// stacks[stack].drawn[first, last)
+	struct Outcome {
+		Atom value;
+		EvalError error;
+		bool ok = false;
+		std::size_t stack = 0;
+		std::size_t begin = 0;
+		std::size_t end = 0;
+		std::size_t first = 0;
+		std::size_t last = 0;
+	};
+	static const std::size_t MinParallelChildren = 32;
+	std::unique_ptr<ThreadPool> pool;
+	std::vector<EvalStack> stacks; // one for each pool worker
+	std::vector<Access> accesses;
+	std::vector<Outcome> outcomes;
+	std::vector<const AstNode*> walk;
+	void analyze(const AstNode& exp, Access& access);
+	bool evalParallel(const AstNode& root, Atom& result, EvalError& error);
+	bool evalWave(const AstNode& root, std::size_t first, std::size_t last, Atom& result, EvalError& error);
+
+	// a cached result of parseAndEvaluate
+	struct CacheEntry {
+		std::string text;      // the input the result was stored for
+		Expression result;
+		std::uint64_t version; // env.version() when evaluated
+		std::vector<std::pair<SymbolId, std::uint64_t>> reads; // symbols read and their stamps
+	};
+	static const std::size_t MaxCacheEntries = 4096;
+	std::unordered_map<std::uint64_t, CacheEntry> cache; // keyed by hashTokens()
+	std::unordered_map<std::size_t, std::uint64_t> inputs; // hash of an entry's text to its key
+	TokenViewSequenceType entryTokens;
+	bool caching = false;
+	std::size_t hits = 0;
+	std::size_t misses = 0;
+	std::uint64_t hashTokens() const;
+	bool isCurrent(const CacheEntry& entry) const;
+	bool matchesTokens(const std::string& text);
+	bool cacheable() const;
+	void storeResult(std::uint64_t hash, const Expression& result);
+
+	EvalMode mode = TreeWalkMode;
+	Program program;      // bytecode of ast, valid if compiled
+	bool compiled = false;
+	VirtualMachine vm;
+
 };
 
 
@@ -0,0 +1,90 @@
+#ifndef KEYWORDS_HPP
+#define KEYWORDS_HPP
+
+// system includes
+#include <cstddef>
+#include <cstring>
+
+// module includes
+#include "symbol_table.hpp"
+
+// names of the keywords, in KeywordId order
+constexpr const char* keyword_names[KeywordCount] = {
+    "",
+    "define", "begin", "if",
+    "True", "False", "pi",
+    "+", "-", "*", "/", "sqrt", "log2",
+    "<", "<=", ">", ">=", "==",
+    "and", "or", "not",
+    "sin", "cos", "arctan",
+    "range", "linspace",
+    "point", "line", "arc", "rect", "fill_rect", "ellipse", "draw",
+};
+
+// a perfect hash of the keyword names, generated at compile time: every
+// keyword has a slot of its own, so a name is classified by hashing it and
+// comparing it with the one keyword in its slot
+namespace keyword_hash {
+
+const std::size_t Slots = 64;
+
+constexpr std::size_t length(const char* name) {
+    return *name == '\0' ? 0 : 1 + length(name + 1);
+}
+
+// slot of a name of length n > 0, from its length and first, second and last characters
+constexpr std::size_t slot(const char* name, std::size_t n) {
+    return (static_cast<unsigned char>(name[0]) * 2u + static_cast<unsigned char>(name[n - 1]) * 61u + n * 46u
+        + (n > 1 ? static_cast<unsigned char>(name[1]) : 0u)) & (Slots - 1);
+}
+
+constexpr std::size_t slot_of(SymbolId id) {
+    return slot(keyword_names[id], length(keyword_names[id]));
+}
+
+// the keyword from id on hashed to slot, KeywordCount if none
+constexpr SymbolId keyword_in(std::size_t slot, SymbolId id) {
+    return id == KeywordCount ? SymbolId(KeywordCount) : slot_of(id) == slot ? id : keyword_in(slot, id + 1);
+}
+
+// true if no keyword from other on has the slot of id
+constexpr bool distinct(SymbolId id, SymbolId other) {
+    return other == KeywordCount || (slot_of(id) != slot_of(other) && distinct(id, other + 1));
+}
+
+// true if every keyword from id on has a slot of its own
+constexpr bool perfect(SymbolId id) {
+    return id == KeywordCount || (distinct(id, id + 1) && perfect(id + 1));
+}
+
+// EmptyId is not hashed, no token is empty
+static_assert(perfect(EmptyId + 1), "two keywords share a slot, change the constants of slot");
+
+// the table of the keyword in each slot, as the pack expansion of keyword_in over 0 .. Slots - 1
+template <std::size_t... I> struct Indices {};
+template <std::size_t N, std::size_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <std::size_t... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+template <class Sequence> struct Table;
+template <std::size_t... I> struct Table<Indices<I...>> {
+    static constexpr SymbolId ids[sizeof...(I)] = { keyword_in(I, EmptyId + 1)... };
+};
+template <std::size_t... I> constexpr SymbolId Table<Indices<I...>>::ids[sizeof...(I)];
+
+typedef Table<MakeIndices<Slots>::type> SlotTable;
+
+} // namespace keyword_hash
+
+// the keyword named by name[0, length), KeywordCount if it is none
+inline KeywordId find_keyword(const char* name, std::size_t length) {
+    if (length == 0) {
+        return KeywordCount;
+    }
+    SymbolId id = keyword_hash::SlotTable::ids[keyword_hash::slot(name, length)];
+    if (id != KeywordCount && std::strncmp(keyword_names[id], name, length) == 0 && keyword_names[id][length] == '\0') {
+        return static_cast<KeywordId>(id);
+    }
+    return KeywordCount;
+}
+
+#endif
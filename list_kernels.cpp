@@ -0,0 +1,202 @@
+#include "list_kernels.hpp"
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define LIST_KERNELS_HAVE_X86 1
+#endif
+
+namespace {
+
+// the operations, each with a scalar and vector form
+struct Add {
+    static double scalar(double a, double b) { return a + b; }
+#ifdef LIST_KERNELS_HAVE_X86
+    static __m128d sse2(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+    __attribute__((target("avx")))
+    static __m256d avx(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+#endif
+};
+
+struct Subtract {
+    static double scalar(double a, double b) { return a - b; }
+#ifdef LIST_KERNELS_HAVE_X86
+    static __m128d sse2(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+    __attribute__((target("avx")))
+    static __m256d avx(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+#endif
+};
+
+struct Multiply {
+    static double scalar(double a, double b) { return a * b; }
+#ifdef LIST_KERNELS_HAVE_X86
+    static __m128d sse2(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+    __attribute__((target("avx")))
+    static __m256d avx(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+#endif
+};
+
+struct Divide {
+    static double scalar(double a, double b) { return a / b; }
+#ifdef LIST_KERNELS_HAVE_X86
+    static __m128d sse2(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+    __attribute__((target("avx")))
+    static __m256d avx(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+#endif
+};
+
+template <class Op>
+void binary_scalar(const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t pos, std::size_t size) {
+    for (; pos < size; ++pos) {
+        out[pos] = Op::scalar(a[a_scalar ? 0 : pos], b[b_scalar ? 0 : pos]);
+    }
+}
+
+void sqrt_scalar(const double* in, double* out, std::size_t pos, std::size_t size) {
+    for (; pos < size; ++pos) {
+        out[pos] = std::sqrt(in[pos]);
+    }
+}
+
+#ifdef LIST_KERNELS_HAVE_X86
+
+template <class Op>
+void binary_sse2(const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size) {
+    __m128d a_all = _mm_set1_pd(a[0]);
+    __m128d b_all = _mm_set1_pd(b[0]);
+
+    std::size_t pos = 0;
+    for (; pos + 2 <= size; pos += 2) {
+        __m128d x = a_scalar ? a_all : _mm_loadu_pd(a + pos);
+        __m128d y = b_scalar ? b_all : _mm_loadu_pd(b + pos);
+        _mm_storeu_pd(out + pos, Op::sse2(x, y));
+    }
+    binary_scalar<Op>(a, a_scalar, b, b_scalar, out, pos, size);
+}
+
+template <class Op>
+__attribute__((target("avx")))
+void binary_avx(const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size) {
+    __m256d a_all = _mm256_set1_pd(a[0]);
+    __m256d b_all = _mm256_set1_pd(b[0]);
+
+    std::size_t pos = 0;
+    for (; pos + 4 <= size; pos += 4) {
+        __m256d x = a_scalar ? a_all : _mm256_loadu_pd(a + pos);
+        __m256d y = b_scalar ? b_all : _mm256_loadu_pd(b + pos);
+        _mm256_storeu_pd(out + pos, Op::avx(x, y));
+    }
+    binary_scalar<Op>(a, a_scalar, b, b_scalar, out, pos, size);
+}
+
+void sqrt_sse2(const double* in, double* out, std::size_t size) {
+    std::size_t pos = 0;
+    for (; pos + 2 <= size; pos += 2) {
+        _mm_storeu_pd(out + pos, _mm_sqrt_pd(_mm_loadu_pd(in + pos)));
+    }
+    sqrt_scalar(in, out, pos, size);
+}
+
+__attribute__((target("avx")))
+void sqrt_avx(const double* in, double* out, std::size_t size) {
+    std::size_t pos = 0;
+    for (; pos + 4 <= size; pos += 4) {
+        _mm256_storeu_pd(out + pos, _mm256_sqrt_pd(_mm256_loadu_pd(in + pos)));
+    }
+    sqrt_scalar(in, out, pos, size);
+}
+
+#endif
+
+// run Op with kernel, which the CPU supports
+template <class Op>
+void binary(ListKernel kernel, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size) {
+    switch (kernel) {
+#ifdef LIST_KERNELS_HAVE_X86
+    case AVXKernel:
+        binary_avx<Op>(a, a_scalar, b, b_scalar, out, size);
+        break;
+    case SSE2Kernel:
+        binary_sse2<Op>(a, a_scalar, b, b_scalar, out, size);
+        break;
+#endif
+    default:
+        binary_scalar<Op>(a, a_scalar, b, b_scalar, out, 0, size);
+        break;
+    }
+}
+
+// kernel, or the best supported one if the CPU does not support it
+ListKernel supported(ListKernel kernel) {
+    return kernel > best_list_kernel() ? best_list_kernel() : kernel;
+}
+
+} // namespace
+
+ListKernel best_list_kernel() {
+#ifdef LIST_KERNELS_HAVE_X86
+    static const ListKernel best = __builtin_cpu_supports("avx") ? AVXKernel : SSE2Kernel;
+    return best;
+#else
+    return ScalarKernel;
+#endif
+}
+
+void list_binary(ListOp op, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size) {
+    list_binary(op, a, a_scalar, b, b_scalar, out, size, best_list_kernel());
+}
+
+void list_binary(ListOp op, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size, ListKernel kernel) {
+    kernel = supported(kernel);
+
+    switch (op) {
+    case ListAdd:
+        binary<Add>(kernel, a, a_scalar, b, b_scalar, out, size);
+        break;
+    case ListSubtract:
+        binary<Subtract>(kernel, a, a_scalar, b, b_scalar, out, size);
+        break;
+    case ListMultiply:
+        binary<Multiply>(kernel, a, a_scalar, b, b_scalar, out, size);
+        break;
+    case ListDivide:
+        binary<Divide>(kernel, a, a_scalar, b, b_scalar, out, size);
+        break;
+    }
+}
+
+void list_sqrt(const double* in, double* out, std::size_t size) {
+    list_sqrt(in, out, size, best_list_kernel());
+}
+
+void list_sqrt(const double* in, double* out, std::size_t size, ListKernel kernel) {
+    switch (supported(kernel)) {
+#ifdef LIST_KERNELS_HAVE_X86
+    case AVXKernel:
+        sqrt_avx(in, out, size);
+        break;
+    case SSE2Kernel:
+        sqrt_sse2(in, out, size);
+        break;
+#endif
+    default:
+        sqrt_scalar(in, out, 0, size);
+        break;
+    }
+}
+
+void list_sin(const double* in, double* out, std::size_t size) {
+    for (std::size_t pos = 0; pos < size; ++pos) {
+        out[pos] = std::sin(in[pos]);
+    }
+}
+
+void list_cos(const double* in, double* out, std::size_t size) {
+    for (std::size_t pos = 0; pos < size; ++pos) {
+        out[pos] = std::cos(in[pos]);
+    }
+}
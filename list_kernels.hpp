@@ -0,0 +1,34 @@
+#ifndef LIST_KERNELS_HPP
+#define LIST_KERNELS_HPP
+
+// system includes
+#include <cstddef>
+
+// element-wise arithmetic on arrays of doubles, the kernels behind the
+// List builtins. The SIMD kernels process 2 or 4 numbers at a time and
+// give the same results as the scalar one
+enum ListOp { ListAdd, ListSubtract, ListMultiply, ListDivide };
+
+enum ListKernel { ScalarKernel, SSE2Kernel, AVXKernel };
+
+// fastest kernel supported by this CPU
+ListKernel best_list_kernel();
+
+// out[i] = a[i] op b[i] for i < size. A scalar operand (a_scalar or
+// b_scalar) is a[0] or b[0] for every i. out may be the same array as an
+// operand that is not scalar
+void list_binary(ListOp op, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size);
+
+// out[i] = sqrt(in[i]) for i < size
+void list_sqrt(const double* in, double* out, std::size_t size);
+
+// out[i] = sin(in[i]) or cos(in[i]) for i < size, libm has no vector
+// versions so these are scalar loops
+void list_sin(const double* in, double* out, std::size_t size);
+void list_cos(const double* in, double* out, std::size_t size);
+
+// the same with a given kernel, or the best supported one if it is not available
+void list_binary(ListOp op, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, std::size_t size, ListKernel kernel);
+void list_sqrt(const double* in, double* out, std::size_t size, ListKernel kernel);
+
+#endif
@@ -21,6 +21,7 @@ MainWindow::MainWindow(QWidget* parent) : QWidget(parent), interpreter(this) {
     // Connecting the interpreter's outputs to GUI components
     // connection for graphical objects
     connect(&interpreter, &QtInterpreter::drawGraphic, canvasWidget, &CanvasWidget::addGraphic);
+    connect(&interpreter, &QtInterpreter::drawGraphics, canvasWidget, &CanvasWidget::addGraphics);
 
     // connection allows informational messages from QtInterpreter to be shown to the user in MessageWidget
     connect(&interpreter, &QtInterpreter::info, messageWidget, &MessageWidget::info);
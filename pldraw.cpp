@@ -5,14 +5,73 @@
 
 
 #include <QApplication>
+#include <QGuiApplication>
 #include "main_window.hpp"
+#include "headless_render.hpp"
 
 #include "interpreter.hpp"
 #include "interpreter_semantic_error.hpp"
 
 
+static int render_usage() {
+    std::cerr << "Error: Invalid arguments\n";
+    std::cerr << "Usage:\n";
+    std::cerr << "  pldraw --render <filename> -o <image> [options]\n";
+    std::cerr << "    -o <image>       .png or .svg file to write\n";
+    std::cerr << "    --size <w>x<h>   image size in pixels, default 800x600\n";
+    std::cerr << "    --scale <s>      pixels per unit, default fits the drawing\n";
+    std::cerr << "    --timing         report the time from startup to the file\n";
+    return EXIT_FAILURE;
+}
+
+// pldraw --render, draw a script to an image without a display or widgets
+static int render(int argc, char* argv[], RenderOptions& options) {
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        }
+        else if (arg == "--size" && i + 1 < argc) {
+            char x = 0;
+            std::istringstream iss(argv[++i]);
+            if (!(iss >> options.width >> x >> options.height) || x != 'x' || !iss.eof()) {
+                return render_usage();
+            }
+        }
+        else if (arg == "--scale" && i + 1 < argc) {
+            std::istringstream iss(argv[++i]);
+            if (!(iss >> options.scale) || !iss.eof() || options.scale <= 0) {
+                return render_usage();
+            }
+        }
+        else if (arg == "--timing") {
+            options.timing = true;
+        }
+        else if (options.input.empty() && !arg.empty() && arg[0] != '-') {
+            options.input = arg;
+        }
+        else {
+            return render_usage();
+        }
+    }
+    if (options.input.empty() || options.output.empty()) {
+        return render_usage();
+    }
+
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) { // no display needed
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    return render_script(options);
+}
+
 // used outline from postlisp
 int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--render") {
+        RenderOptions options; // the clock starts here
+        return render(argc, argv, options);
+    }
+
     QApplication app(argc, argv);
     Interpreter interpreter;
     if (argc == 1) { // REPL 
@@ -61,6 +120,7 @@ int main(int argc, char* argv[]) {
         std::cerr << "  pldraw                 Start GUI mode\n";
         std::cerr << "  pldraw <filename>      Open file in GUI\n";
         std::cerr << "  pldraw -e \"<expr>\"     Execute expression from command line\n";
+        std::cerr << "  pldraw --render <filename> -o <image>  Draw file to a .png or .svg image\n";
         return EXIT_FAILURE;
     }
 }
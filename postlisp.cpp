@@ -1,6 +1,277 @@
+// postlisp, the interpreter without the GUI
+//
+//   postlisp                         read-eval-print loop
+//   postlisp -e "<program>"          evaluate a program given on the command line
+//   postlisp <file>                  evaluate a script file
+//   postlisp [options] <file>...     evaluate many scripts in parallel
+//
+// options of the batch mode:
+//   -j <threads>      number of threads, all cores by default
+//   -m <manifest>     also evaluate the scripts listed in manifest, one path per
+//                     line, blank lines and lines starting with # are skipped
+//   --timing          report the time each script took and a summary
+//   --share           store repeated subexpressions of a script once, which
+//                     saves memory on large generated scripts, also for a
+//                     single file
+//
+// In batch mode every script gets its own interpreter. The scripts are run
+// largest first on a thread pool, and "path: result" lines are printed in the
+// order the scripts were given as soon as all scripts before them are done.
+// The exit status is nonzero if any script failed.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main(int argc, char *argv[]) {
+#include "interpreter.hpp"
+#include "thread_pool.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+// seconds elapsed since start
+static double elapsed(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// messages of builtins do not all start with Error
+static std::string error_text(const std::string& message) {
+    return message.compare(0, 5, "Error") == 0 ? message : "Error: " + message;
+}
+
+static bool read_file(const std::string& path, std::string& text) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+    text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// evaluate program as a single form in a new interpreter, output is the
+// result or the error message
+static bool run_program(const std::string& program, bool share, std::string& output) {
+    Interpreter interpreter;
+    interpreter.setSharedSubtrees(share);
+    EvalError error;
+    if (interpreter.tryParse(program, error)) {
+        EvalResult result = interpreter.tryEval();
+        if (result.ok()) {
+            output = result.value.toString();
+            return true;
+        }
+        error = result.error;
+    }
+    output = error_text(error.message());
+    return false;
+}
+
+static int repl() {
+    Interpreter interpreter;
+    interpreter.setResultCache(true); // lines entered again are not evaluated again
+    std::string line;
+    for (;;) {
+        std::cout << "postlisp> " << std::flush;
+        if (!std::getline(std::cin, line)) {
+            std::cout << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        // definitions are kept from line to line
+        EvalResult result = interpreter.tryParseAndEvaluate(line);
+        if (result.ok()) {
+            std::cout << result.value << std::endl;
+        }
+        else {
+            std::cout << error_text(result.error.message()) << std::endl;
+        }
+    }
+}
+
+// evaluate one program, print its result or report its error
+static int run_single(const std::string& program, bool share) {
+    std::string output;
+    if (!run_program(program, share, output)) {
+        std::cerr << output << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << output << std::endl;
     return EXIT_SUCCESS;
 }
 
+// a script of the batch and what evaluating it gave
+struct Script {
+    std::string path;
+    std::streamoff size = 0; // bytes, to start the largest scripts first
+    std::string output;
+    bool ok = false;
+    bool done = false;
+    double seconds = 0;
+};
+
+static void run_script(Script& script, bool share) {
+    try {
+        std::string text;
+        if (!read_file(script.path, text)) {
+            script.output = "Error: could not open file '" + script.path + "'";
+            return;
+        }
+        script.ok = run_program(text, share, script.output);
+    }
+    catch (const std::exception& err) { // out of memory, tasks of the pool must not throw
+        script.output = std::string("Error: ") + err.what();
+        script.ok = false;
+    }
+}
+
+static int run_batch(std::vector<Script>& scripts, std::size_t threads, bool timing, bool share) {
+    for (Script& script : scripts) {
+        std::ifstream ifs(script.path, std::ios::binary | std::ios::ate);
+        script.size = ifs ? static_cast<std::streamoff>(ifs.tellg()) : 0;
+    }
+
+    // largest first, so a long script does not start last and hold up the batch
+    std::vector<std::size_t> order(scripts.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return scripts[a].size > scripts[b].size;
+    });
+
+    std::mutex mutex;
+    std::size_t printed = 0;
+    std::size_t failed = 0;
+    Clock::time_point start = Clock::now();
+
+    ThreadPool pool(std::min(threads, std::max<std::size_t>(scripts.size(), 1)));
+    pool.run(scripts.size(), [&](std::size_t, std::size_t index) {
+        Script& script = scripts[order[index]];
+        Clock::time_point begin = Clock::now();
+        run_script(script, share);
+        script.seconds = elapsed(begin);
+
+        // print the done scripts that come next in order
+        std::lock_guard<std::mutex> lock(mutex);
+        script.done = true;
+        for (; printed < scripts.size() && scripts[printed].done; ++printed) {
+            const Script& next = scripts[printed];
+            std::cout << next.path << ": " << next.output;
+            if (timing) {
+                std::cout << " (" << next.seconds * 1000 << " ms)";
+            }
+            std::cout << "\n";
+            failed += next.ok ? 0 : 1;
+        }
+        std::cout.flush();
+    });
+
+    if (timing) {
+        double total = 0;
+        for (const Script& script : scripts) {
+            total += script.seconds;
+        }
+        std::cerr << scripts.size() << " scripts, " << failed << " failed, "
+                  << elapsed(start) * 1000 << " ms on " << pool.size() << " threads ("
+                  << total * 1000 << " ms of script time)" << std::endl;
+    }
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// append the paths listed in manifest to scripts
+static bool read_manifest(const std::string& manifest, std::vector<Script>& scripts) {
+    std::ifstream ifs(manifest);
+    if (!ifs) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::size_t last = line.find_last_not_of(" \t\r");
+        scripts.push_back(Script());
+        scripts.back().path = line.substr(first, last - first + 1);
+    }
+    return true;
+}
+
+static int usage() {
+    std::cerr << "Error: Invalid arguments\n";
+    std::cerr << "Usage:\n";
+    std::cerr << "  postlisp                          Start the REPL\n";
+    std::cerr << "  postlisp -e \"<expr>\"              Execute expression from command line\n";
+    std::cerr << "  postlisp <filename>               Execute file\n";
+    std::cerr << "  postlisp [options] <filename>...  Execute files in parallel\n";
+    std::cerr << "    -j <threads>   number of threads, default all cores\n";
+    std::cerr << "    -m <manifest>  execute the files listed in manifest\n";
+    std::cerr << "    --timing       report the time of each file\n";
+    std::cerr << "    --share        store repeated subexpressions once\n";
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        return repl();
+    }
+    if (argc == 3 && std::string(argv[1]) == "-e") {
+        return run_single(argv[2], false);
+    }
+
+    std::vector<Script> scripts;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool batch = false;
+    bool timing = false;
+    bool share = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = std::max(1L, std::strtol(argv[++i], nullptr, 10));
+            batch = true;
+        }
+        else if (arg == "-m" && i + 1 < argc) {
+            if (!read_manifest(argv[++i], scripts)) {
+                std::cerr << "Error: could not open manifest '" << argv[i] << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            batch = true;
+        }
+        else if (arg == "--timing") {
+            timing = true;
+            batch = true;
+        }
+        else if (arg == "--share") {
+            share = true;
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            return usage();
+        }
+        else {
+            scripts.push_back(Script());
+            scripts.back().path = arg;
+        }
+    }
+
+    if (scripts.size() == 1 && !batch) { // a single file prints just its result
+        std::string text;
+        if (!read_file(scripts[0].path, text)) {
+            std::cerr << "Error: could not open file '" << scripts[0].path << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return run_single(text, share);
+    }
+    if (scripts.empty() && !batch) {
+        return usage();
+    }
+    return run_batch(scripts, threads, timing, share);
+}
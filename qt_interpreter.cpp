@@ -3,122 +3,155 @@
 
 // implemented with help form AI (primarly with the Brush and Pen aspect)
 
+// the rect between two corners
+static QRectF rect_of(const Rectt& rect) {
+    double x = std::min(rect.point1.x, rect.point2.x);
+    double y = std::min(rect.point1.y, rect.point2.y);
+    return QRectF(x, y, std::fabs(rect.point2.x - rect.point1.x), std::fabs(rect.point2.y - rect.point1.y));
+}
+
+// the box of the circle of an arc, whose radius reaches its start point,
+// and its start and span angles in 1/16 of a degree
+static void arc_of(const Arcn& arc, QRectF& box, int& start, int& span) {
+    double radius = std::hypot(arc.start.x - arc.center.x, arc.start.y - arc.center.y);
+    box = QRectF(arc.center.x - radius, arc.center.y - radius, radius * 2, radius * 2);
+
+    double degrees = 180 / std::atan2(0, -1);
+    start = static_cast<int>(std::atan2(arc.start.y - arc.center.y, arc.start.x - arc.center.x) * degrees * 16);
+    span = static_cast<int>(arc.angle * degrees * 16);
+}
+
+// the item showing graphic, nullptr if it is not a graphic
+static QGraphicsItem* make_item(const Atom& graphic) {
+    if (graphic.type == PointType) { // making the point
+        // point with a small circle (ellipse) for this chatgpt helped me to get the -2.5 for the point values
+        auto* point = new QGraphicsEllipseItem(graphic.value.point_value.x - 2.5, graphic.value.point_value.y - 2.5, 10, 10);
+        point->setBrush(Qt::black); // set the color as black 
+        return point;
+    }
+    else if (graphic.type == LineType) { // making a line
+        // start and end points from result
+        QPointF start(graphic.value.line_value.start.x, graphic.value.line_value.start.y);
+        QPointF end(graphic.value.line_value.end.x, graphic.value.line_value.end.y);
+
+        // create the QGraphicsLineItem from start to end
+        auto* line = new QGraphicsLineItem(QLineF(start, end));
+        line->setPen(QPen(Qt::black, 3)); // set color and thickness
+        line->setPen(QPen(Qt::black, 3)); // set color and thickness
+        return line;
+    } 
+    else if (graphic.type == ArcType) { // making an arc (with help from AI to fix previous code)
+        // box of the arc's circle and its angles, in Qt's 1/16 degree units
+        QRectF box;
+        int startAngle, spanAngle;
+        arc_of(graphic.value.arc_value, box, startAngle, spanAngle);
+
+        auto* arcItem = new QGraphicsArcItem(box.x(), box.y(), box.width(), box.height());
+        arcItem->setStartAngle(startAngle);
+        arcItem->setSpanAngle(spanAngle);
+        arcItem->setPen(QPen(Qt::black, 3)); // set color and thickness
+
+        return arcItem;
+    }
+    // below is worked on after beta
+    else if (graphic.type == RectType) {
+        // Creating rectangle
+        auto* rectItem = new QGraphicsRectItem(rect_of(graphic.value.rect_value));
+        rectItem->setPen(QPen(Qt::black, 3)); // set color and thickness
+        rectItem->setBrush(Qt::NoBrush);  // no fill 
+        return rectItem;
+    }
+    else if (graphic.type == FillRectType) {
+        // RGB vals
+        int r = static_cast<int>(graphic.value.fill_rect_value.r);
+        int g = static_cast<int>(graphic.value.fill_rect_value.g);
+        int b = static_cast<int>(graphic.value.fill_rect_value.b);
+
+        auto* fillRectItem = new QGraphicsRectItem(rect_of(graphic.value.fill_rect_value.rect));
+        fillRectItem->setBrush(QBrush(QColor(r, g, b)));  // brush fill with color vals
+        fillRectItem->setPen(Qt::NoPen); // canvas examples have boarders, you can't have it for tests
+
+        
+        return fillRectItem;
+    }
+    else if (graphic.type == EllipseType) {
+        // Creating ellipse
+        auto* ellipseItem = new QGraphicsEllipseItem(rect_of(graphic.value.ellipse_value.rect));
+        ellipseItem->setPen(QPen(Qt::black, 3)); // set color and thickness
+
+        return ellipseItem;
+    }
+    return nullptr;
+}
+
+// add graphic to list, looking as the item make_item gives for it
+void add_graphic(DisplayListItem& list, const Atom& graphic) {
+    if (graphic.type == PointType) {
+        // the center of the point item's circle
+        list.addPoint(QPointF(graphic.value.point_value.x + 2.5, graphic.value.point_value.y + 2.5));
+    }
+    else if (graphic.type == LineType) {
+        const Line& line = graphic.value.line_value;
+        list.addLine(QLineF(line.start.x, line.start.y, line.end.x, line.end.y));
+    }
+    else if (graphic.type == ArcType) {
+        QRectF box;
+        int start, span;
+        arc_of(graphic.value.arc_value, box, start, span);
+        list.addArc(box, start, span);
+    }
+    else if (graphic.type == RectType) {
+        list.addRect(rect_of(graphic.value.rect_value));
+    }
+    else if (graphic.type == FillRectType) {
+        const FillRectt& fill = graphic.value.fill_rect_value;
+        QColor color(static_cast<int>(fill.r), static_cast<int>(fill.g), static_cast<int>(fill.b));
+        list.addFillRect(rect_of(fill.rect), color.rgb());
+    }
+    else if (graphic.type == EllipseType) {
+        list.addEllipse(rect_of(graphic.value.ellipse_value.rect));
+    }
+}
+
 // default constuctor
-QtInterpreter::QtInterpreter(QObject* parent) : QObject(parent) {}
+QtInterpreter::QtInterpreter(QObject* parent) : QObject(parent) {
+    // forms entered again in the REPL are not evaluated again
+    interpreter.setResultCache(true);
+
+    // graphics reach the canvas in batches while a script runs
+    interpreter.geometry().setHandler(DrawBatch, [this](const std::vector<Atom>& graphics) {
+        QVector<QGraphicsItem*> items;
+        if (graphics.size() >= static_cast<std::size_t>(DisplayListMin)) { // one item paints the whole batch
+            auto* list = new DisplayListItem();
+            for (const Atom& graphic : graphics) {
+                add_graphic(*list, graphic);
+            }
+            items.push_back(list);
+        }
+        else {
+            items.reserve(static_cast<int>(graphics.size()));
+            for (const Atom& graphic : graphics) {
+                if (QGraphicsItem* item = make_item(graphic)) {
+                    items.push_back(item);
+                }
+            }
+        }
+        emit drawGraphics(items);
+    });
+}
 
 void QtInterpreter::parseAndEvaluate(QString entry) {
     try {
+        std::size_t drawn = interpreter.geometry().drawn();
 
         // parse and eval the input, converts from QString to std::string
         Expression result = interpreter.parseAndEvaluate(entry.toStdString());
 
-        // emit graphics, messages based on eval result
-        if (result.head.type == PointType) { // making the point
-            // point with a small circle (ellipse) for this chatgpt helped me to get the -2.5 for the point values
-            auto* point = new QGraphicsEllipseItem(result.head.value.point_value.x - 2.5, result.head.value.point_value.y - 2.5, 10, 10);
-            point->setBrush(Qt::black); // set the color as black 
-            emit drawGraphic(point); // emit to draw on canvas
-        }
-        else if (result.head.type == LineType) { // making a line
-            // start and end points from result
-            QPointF start(result.head.value.line_value.start.x, result.head.value.line_value.start.y);
-            QPointF end(result.head.value.line_value.end.x, result.head.value.line_value.end.y);
-
-            // create the QGraphicsLineItem from start to end
-            auto* line = new QGraphicsLineItem(QLineF(start, end));
-            line->setPen(QPen(Qt::black, 3)); // set color and thickness
-            line->setPen(QPen(Qt::black, 3)); // set color and thickness
-            emit drawGraphic(line); // emit to draw on canvas
-        } 
-        else if (result.head.type == ArcType) { // making an arc (with help from AI to fix previous code)
-            // getting x and y center cordinates values
-            double centerX = result.head.value.arc_value.center.x;
-            double centerY = result.head.value.arc_value.center.y;
-
-            // calculating the radius of the arc (center ot the start point)
-            double radius = std::hypot(result.head.value.arc_value.start.x - centerX,
-                result.head.value.arc_value.start.y - centerY);
-
-            // box for the arc
-            double x = centerX - radius; // left side
-            double y = centerY - radius; // top side
-            double di = radius * 2; // diameter of the box
-
-            // starting angle for box 
-            double startAngle = atan2(result.head.value.arc_value.start.y - centerY,
-                result.head.value.arc_value.start.x - centerX) * (180 / std::atan2(0, -1));
-            // calculatin gthe span angle 
-            double spanAngle = result.head.value.arc_value.angle * (180 / std::atan2(0, -1));
-
-            auto* arcItem = new QGraphicsArcItem(x, y, di, di);
-            // start and span angles (have to convert to Qt's 1/16 degree units)
-            arcItem->setStartAngle(startAngle * 16); // Use Qt's 1/16th degree units
-            arcItem->setSpanAngle(spanAngle * 16);
-            arcItem->setPen(QPen(Qt::black, 3)); // set color and thickness
-
-            emit drawGraphic(arcItem); // emit to draw on canvas
-        }
-        // below is worked on after beta
-        else if (result.head.type == RectType) {
-            // two points for rect 
-            double x1 = result.head.value.rect_value.point1.x;
-            double y1 = result.head.value.rect_value.point1.y;
-            double x2 = result.head.value.rect_value.point2.x;
-            double y2 = result.head.value.rect_value.point2.y;
-
-            // get the dimensions for QGraphicsRectItem function
-            double x = std::min(x1, x2);
-            double y = std::min(y1, y2);
-            double width = std::fabs(x2 - x1);
-            double height = std::fabs(y2 - y1);
-
-            // Creating rectangle
-            auto* rectItem = new QGraphicsRectItem(x, y, width, height);
-            rectItem->setPen(QPen(Qt::black, 3)); // set color and thickness
-            rectItem->setBrush(Qt::NoBrush);  // no fill 
-            emit drawGraphic(rectItem);      // emit to draw on canvas
-        }
-        else if (result.head.type == FillRectType) {
-            // same beginning as rect
-            double x1 = result.head.value.fill_rect_value.rect.point1.x;
-            double y1 = result.head.value.fill_rect_value.rect.point1.y;
-            double x2 = result.head.value.fill_rect_value.rect.point2.x;
-            double y2 = result.head.value.fill_rect_value.rect.point2.y;
-
-            double x = std::min(x1, x2);
-            double y = std::min(y1, y2);
-            double width = std::fabs(x2 - x1);
-            double height = std::fabs(y2 - y1);
-
-            // RGB vals
-            int r = static_cast<int>(result.head.value.fill_rect_value.r);
-            int g = static_cast<int>(result.head.value.fill_rect_value.g);
-            int b = static_cast<int>(result.head.value.fill_rect_value.b);
-
-            auto* fillRectItem = new QGraphicsRectItem(x, y, width, height);
-            fillRectItem->setBrush(QBrush(QColor(r, g, b)));  // brush fill with color vals
-            fillRectItem->setPen(Qt::NoPen); // canvas examples have boarders, you can't have it for tests
-
-            
-            emit drawGraphic(fillRectItem);// emit to draw on canvas
-        }
-        else if (result.head.type == EllipseType) {
-            // same as rectange getting the points 
-            double x1 = result.head.value.ellipse_value.rect.point1.x;
-            double y1 = result.head.value.ellipse_value.rect.point1.y;
-            double x2 = result.head.value.ellipse_value.rect.point2.x;
-            double y2 = result.head.value.ellipse_value.rect.point2.y;
-
-            double x = std::min(x1, x2);
-            double y = std::min(y1, y2);
-            double width = std::fabs(x2 - x1);
-            double height = std::fabs(y2 - y1);
-
-            // Creating ellipse
-            auto* ellipseItem = new QGraphicsEllipseItem(x, y, width, height);
-            ellipseItem->setPen(QPen(Qt::black, 3)); // set color and thickness
-
-            emit drawGraphic(ellipseItem);// emit to draw on canvas
+        // a graphic result is shown unless the input drew with draw
+        if (interpreter.geometry().drawn() == drawn) {
+            if (QGraphicsItem* item = make_item(result.head)) {
+                emit drawGraphic(item);
+            }
         }
 
         emit info(QString::fromStdString(result.toString())); // for the postlisp commands
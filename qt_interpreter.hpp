@@ -6,11 +6,16 @@
 #include <QGraphicsLineItem>
 #include <QGraphicsScene>
 #include <QPen>
+#include <QVector>
 #include <cmath> 
 #include "interpreter.hpp"
 #include "qgraphics_arc_item.hpp"
+#include "display_list_item.hpp"
 
 
+// add graphic to list, drawn as the item drawGraphic would emit for it
+void add_graphic(DisplayListItem& list, const Atom& graphic);
+
 class QtInterpreter: public QObject, private Interpreter{
 Q_OBJECT
 
@@ -18,11 +23,21 @@ public:
   // Default construct an QtInterpreter with the default environment and an empty AST
   QtInterpreter(QObject * parent = nullptr);
 
+  // graphics drawn by a script are emitted this many at a time
+  static const int DrawBatch = 4096;
+
+  // a batch of at least this many graphics is drawn by a single
+  // DisplayListItem instead of an item for each graphic
+  static const int DisplayListMin = 64;
+
 signals:
 
   // a signal emitting a graphic to be drawn as a pointer
   void drawGraphic(QGraphicsItem * item);
 
+  // a signal emitting a batch of graphics a script drew, in order
+  void drawGraphics(QVector<QGraphicsItem*> items);
+
 
   // a signal emitting an informational message
   void info(QString message);
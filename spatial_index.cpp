@@ -0,0 +1,102 @@
+#include "spatial_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// true if the rects meet, unlike QRectF::intersects also for lines and points
+static bool overlaps(const QRectF& a, const QRectF& b) {
+    return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+static quint64 key_of(int x, int y) {
+    return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+}
+
+// cells from left to right and top to bottom
+static qint64 cell_count(int left, int right, int top, int bottom) {
+    return (static_cast<qint64>(right) - left + 1) * (static_cast<qint64>(bottom) - top + 1);
+}
+
+GridIndex::GridIndex(qreal cellSize) : cellSize(cellSize) {
+
+}
+
+// cells are clamped far beyond any drawing so the key does not overflow
+int GridIndex::cellOf(qreal coordinate) const {
+    qreal cell = std::floor(coordinate / cellSize);
+    return static_cast<int>(std::max<qreal>(-(1 << 30), std::min<qreal>(1 << 30, cell)));
+}
+
+quint32 GridIndex::insert(const QRectF& rect) {
+    quint32 id = static_cast<quint32>(bounds.size());
+    QRectF box = rect.normalized();
+    bounds.push_back(box);
+
+    int left = cellOf(box.left());
+    int right = cellOf(box.right());
+    int top = cellOf(box.top());
+    int bottom = cellOf(box.bottom());
+    if (cell_count(left, right, top, bottom) > MaxCells) {
+        large.push_back(id);
+        return id;
+    }
+    for (int x = left; x <= right; ++x) {
+        for (int y = top; y <= bottom; ++y) {
+            cells[key_of(x, y)].push_back(id);
+        }
+    }
+    return id;
+}
+
+void GridIndex::query(const QRectF& rect, QVector<quint32>& ids) const {
+    ids.resize(0);
+    QRectF area = rect.normalized();
+
+    int left = cellOf(area.left());
+    int right = cellOf(area.right());
+    int top = cellOf(area.top());
+    int bottom = cellOf(area.bottom());
+
+    // an area covering more cells than there are bounds is scanned whole
+    if (cell_count(left, right, top, bottom) > bounds.size()) {
+        for (quint32 id = 0; id < static_cast<quint32>(bounds.size()); ++id) {
+            if (overlaps(area, bounds[id])) {
+                ids.push_back(id);
+            }
+        }
+        return;
+    }
+
+    // bounds in several cells are reported from the one holding the top
+    // left corner of where they meet area, so once and with nothing to mark
+    for (int x = left; x <= right; ++x) {
+        for (int y = top; y <= bottom; ++y) {
+            auto cell = cells.constFind(key_of(x, y));
+            if (cell == cells.constEnd()) {
+                continue;
+            }
+            for (quint32 id : *cell) {
+                const QRectF& box = bounds[id];
+                if (overlaps(area, box) && x == std::max(left, cellOf(box.left())) && y == std::max(top, cellOf(box.top()))) {
+                    ids.push_back(id);
+                }
+            }
+        }
+    }
+    for (quint32 id : large) {
+        if (overlaps(area, bounds[id])) {
+            ids.push_back(id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+}
+
+void GridIndex::clear() {
+    cells.clear();
+    large.clear();
+    bounds.clear();
+}
+
+quint32 GridIndex::size() const {
+    return static_cast<quint32>(bounds.size());
+}
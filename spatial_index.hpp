@@ -0,0 +1,53 @@
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include <QHash>
+#include <QRectF>
+#include <QVector>
+
+// An index of rectangles, each known by the id insert gave it, answering
+// which of them meet an area. A DisplayListItem keeps one for hit-testing
+// and culling its primitives
+class SpatialIndex {
+
+public:
+  virtual ~SpatialIndex() = default;
+
+  // add bounds, returns its id: the number of bounds added before it
+  virtual quint32 insert(const QRectF& bounds) = 0;
+
+  // the ids of the bounds meeting area, edges included, ascending.
+  // Queries may run concurrently, not with insert or clear
+  virtual void query(const QRectF& area, QVector<quint32>& ids) const = 0;
+
+  virtual void clear() = 0;
+  virtual quint32 size() const = 0;
+};
+
+// A uniform grid of square cells, hashed so the scene has no limits.
+// Bounds are listed in each cell they cover, except bounds covering more
+// than MaxCells cells, such as long lines or large arcs, which are kept
+// aside and tested on every query
+class GridIndex: public SpatialIndex {
+
+public:
+  explicit GridIndex(qreal cellSize = 64);
+
+  quint32 insert(const QRectF& bounds) override;
+  void query(const QRectF& area, QVector<quint32>& ids) const override;
+  void clear() override;
+  quint32 size() const override;
+
+  static const int MaxCells = 64;
+
+private:
+  qreal cellSize;
+  QHash<quint64, QVector<quint32>> cells;
+  QVector<quint32> large;
+  QVector<QRectF> bounds; // by id
+
+  int cellOf(qreal coordinate) const;
+};
+
+
+#endif
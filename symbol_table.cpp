@@ -0,0 +1,69 @@
+#include "symbol_table.hpp"
+#include "keywords.hpp"
+
+#include <stdexcept>
+
+SymbolTable::SymbolTable() : chunks(), count(0) {
+    for (SymbolId id = 0; id < KeywordCount; ++id) {
+        add(keyword_names[id]);
+    }
+}
+
+SymbolTable::~SymbolTable() {
+    for (std::string* chunk : chunks) {
+        delete[] chunk;
+    }
+}
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolId SymbolTable::intern(const char* name, std::size_t length) {
+    return intern(std::string(name, length));
+}
+
+SymbolId SymbolTable::intern(const std::string& name) {
+    // ids never change once given, so a thread can keep the ones it got
+    thread_local std::unordered_map<std::string, SymbolId> known;
+    auto it = known.find(name);
+    if (it != known.end()) {
+        return it->second;
+    }
+
+    SymbolId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = ids.find(name);
+        id = found != ids.end() ? found->second : add(name);
+    }
+    known.emplace(name, id);
+    return id;
+}
+
+// append name with the next id, the mutex is held or the table is being
+// created. The name is written before the count that lets readers see it
+SymbolId SymbolTable::add(const std::string& name) {
+    SymbolId id = count.load(std::memory_order_relaxed);
+    SymbolId chunk = id >> ChunkBits;
+    if (chunk >= MaxChunks) {
+        throw std::length_error("Error: Too many symbols");
+    }
+    if (!chunks[chunk]) {
+        chunks[chunk] = new std::string[ChunkSize];
+    }
+    chunks[chunk][id & (ChunkSize - 1)] = name;
+    ids.emplace(name, id);
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+const std::string& SymbolTable::name(SymbolId id) const {
+    count.load(std::memory_order_acquire); // see the names added before id was given
+    return chunks[id >> ChunkBits][id & (ChunkSize - 1)];
+}
+
+std::size_t SymbolTable::size() const {
+    return count.load(std::memory_order_acquire);
+}
@@ -0,0 +1,107 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+// system includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// A SymbolId is the index of an interned symbol name
+typedef std::uint32_t SymbolId;
+
+// ids fixed when the table is created, the empty name followed by every
+// keyword: special forms, boolean literals, pi and the builtin procedures
+enum KeywordId : SymbolId {
+    EmptyId,
+
+    // special forms
+    DefineId,
+    BeginId,
+    IfId,
+
+    // literals
+    TrueId,
+    FalseId,
+    PiId,
+
+    // arithmetic
+    AddId,
+    SubtractId,
+    MultiplyId,
+    DivideId,
+    SqrtId,
+    Log2Id,
+
+    // comparison
+    LessId,
+    LessEqualId,
+    GreaterId,
+    GreaterEqualId,
+    EqualId,
+
+    // logical
+    AndId,
+    OrId,
+    NotId,
+
+    // trig
+    SinId,
+    CosId,
+    ArctanId,
+
+    // lists
+    RangeId,
+    LinspaceId,
+
+    // graphics
+    PointId,
+    LineId,
+    ArcId,
+    RectId,
+    FillRectId,
+    EllipseId,
+    DrawId,
+
+    KeywordCount
+};
+
+// SymbolTable maps symbol names to dense ids and back, one table is
+// shared by every interpreter in the process. Names are only appended,
+// so name and size read without locking, and each thread remembers the
+// ids it interned so only new names take the lock
+class SymbolTable {
+public:
+    // the process wide table
+    static SymbolTable& global();
+
+    // id of name, adding it to the table if it is new. Throws
+    // std::length_error past MaxChunks * ChunkSize names
+    SymbolId intern(const char* name, std::size_t length);
+    SymbolId intern(const std::string& name);
+
+    // name of an interned id, the reference stays valid for the process
+    const std::string& name(SymbolId id) const;
+
+    // number of interned names
+    std::size_t size() const;
+
+    static const SymbolId ChunkBits = 12;
+    static const SymbolId ChunkSize = 1 << ChunkBits;
+    static const SymbolId MaxChunks = 1 << 12;
+
+private:
+    SymbolTable();
+    ~SymbolTable();
+
+    std::mutex mutex; // held to add a name
+    std::unordered_map<std::string, SymbolId> ids;
+    std::string* chunks[MaxChunks]; // names by id, a chunk is never moved
+    std::atomic<SymbolId> count; // names published to readers
+
+    SymbolId add(const std::string& name);
+};
+
+#endif
@@ -470,7 +470,6 @@ TEST_CASE( "Test file tests/test0.slp", "[interpreter]" ) {
   REQUIRE(ok == false);
 }
 
-/*
 TEST_CASE( "Test syntactically correct file using CRLF (Windows) line endings.", "[interpreter]" ) {
 
   std::string input = TEST_FILE_DIR + "/test_crlf.slp";
@@ -513,4 +512,3 @@ TEST_CASE( "Test all syntactically and semantically CORRECT files.", "[interpret
    
   }
 }
-*/
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(std::size_t workers) : next(0) {
+    for (std::size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back(&ThreadPool::loop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return threads.size() + 1;
+}
+
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t, std::size_t)>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        next = 0;
+        busy = threads.size();
+        ++loops;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    this->task = nullptr;
+}
+
+// take indices of the current loop until none are left
+void ThreadPool::work(std::size_t worker) {
+    for (;;) {
+        std::size_t index = next.fetch_add(1);
+        if (index >= count) {
+            return;
+        }
+        (*task)(worker, index);
+    }
+}
+
+void ThreadPool::loop(std::size_t worker) {
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || loops != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = loops;
+        }
+
+        work(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) {
+            done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// system includes
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A ThreadPool runs parallel loops on a fixed set of threads, which wait
+// between loops instead of being started for each one
+class ThreadPool {
+public:
+    // workers threads in total, the thread calling run is one of them
+    explicit ThreadPool(std::size_t workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const;
+
+    // call task(worker, index) for every index < count and return when all
+    // calls are done. Indices are handed out one at a time, worker < size()
+    // numbers the thread making the call. task must not throw
+    void run(std::size_t count, const std::function<void(std::size_t, std::size_t)>& task);
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake; // a loop started or the pool is stopping
+    std::condition_variable done; // the last worker finished a loop
+
+    const std::function<void(std::size_t, std::size_t)>* task = nullptr;
+    std::size_t count = 0;
+    std::atomic<std::size_t> next;
+    std::size_t busy = 0;        // pool threads still working on the loop
+    std::uint64_t loops = 0;     // number of loops started
+    bool stopping = false;
+
+    void work(std::size_t worker);
+    void loop(std::size_t worker);
+};
+
+#endif
@@ -1,5 +1,12 @@
 #include "tokenizer.hpp"
 
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
 // helper to add a token to the list 
 void add_token(TokenSequenceType& tokens, std::string& current_token) {
     if (!current_token.empty()) {
@@ -16,7 +23,8 @@ TokenSequenceType tokenize(std::istream& seq) {
 
     // input by character
     while (seq.get(ch)) {
-        if (ch == ';') {
+        if (ch == ';') { // ends an atom, as in the buffer tokenizer
+            add_token(tokens, current_token);
             seq.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // skip comment line
             continue;
         }
@@ -38,3 +46,203 @@ TokenSequenceType tokenize(std::istream& seq) {
 
     return tokens;
 }
+
+// helper to classify a byte that ends an atom, whitespace as in the "C" locale
+static inline bool is_delimiter(char ch) {
+    switch (ch) {
+    case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+    case '(': case ')': case ';':
+        return true;
+    default:
+        return false;
+    }
+}
+
+namespace {
+
+// state carried between the blocks of a scan
+struct ScanState {
+    std::size_t start = 0;    // start of the atom being scanned
+    bool in_atom = false;     // currently inside an atom
+};
+
+// scan source[pos, size) one byte at a time
+void scan_scalar(const char* source, std::size_t size, std::size_t pos, ScanState& state, TokenViewSequenceType& tokens) {
+    for (std::size_t i = pos; i < size; ++i) {
+        char ch = source[i];
+
+        if (is_delimiter(ch)) {
+            if (state.in_atom) { // close the current atom
+                tokens.push_back(Token{ state.start, i - state.start, AtomToken });
+                state.in_atom = false;
+            }
+
+            if (ch == ';') { // skip comment line
+                while (i < size && source[i] != '\n') {
+                    ++i;
+                }
+            }
+            else if (ch == '(') {
+                tokens.push_back(Token{ i, 1, OpenToken });
+            }
+            else if (ch == ')') {
+                tokens.push_back(Token{ i, 1, CloseToken });
+            }
+        }
+        else if (!state.in_atom) {
+            state.start = i;
+            state.in_atom = true;
+        }
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define TOKENIZER_HAVE_X86 1
+
+// the blocks below are only scanned with SIMD masks, so the scalar build
+// needs no __builtin_ctz
+
+// handle the block of width bytes at pos given the bit masks of its
+// delimiters and of its '(' ')' ';' bytes, returns where the next block starts
+inline std::size_t scan_block(const char* source, std::size_t size, std::size_t pos, unsigned width,
+                              std::uint32_t delimiters, std::uint32_t specials,
+                              ScanState& state, TokenViewSequenceType& tokens) {
+    // only the bytes where an atom starts or ends, or a special byte, need work
+    std::uint32_t previous = (delimiters << 1) | (state.in_atom ? 0u : 1u);
+    std::uint32_t work = specials | (delimiters ^ previous);
+    if (width < 32) {
+        work &= (1u << width) - 1;
+    }
+
+    while (work != 0) {
+        unsigned k = static_cast<unsigned>(__builtin_ctz(work));
+        work &= work - 1;
+        std::size_t i = pos + k;
+
+        if ((delimiters >> k & 1u) == 0) { // atom starts
+            state.start = i;
+            state.in_atom = true;
+            continue;
+        }
+
+        if (state.in_atom) { // close the current atom
+            tokens.push_back(Token{ state.start, i - state.start, AtomToken });
+            state.in_atom = false;
+        }
+
+        char ch = source[i];
+        if (ch == '(') {
+            tokens.push_back(Token{ i, 1, OpenToken });
+        }
+        else if (ch == ')') {
+            tokens.push_back(Token{ i, 1, CloseToken });
+        }
+        else if (ch == ';') { // skip comment line, the newline is whitespace
+            const void* newline = std::memchr(source + i, '\n', size - i);
+            return newline == nullptr ? size : static_cast<const char*>(newline) - source;
+        }
+    }
+    return pos + width;
+}
+
+// delimiter and special masks of 16 bytes
+inline void masks_sse2(const char* block, std::uint32_t& delimiters, std::uint32_t& specials) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+
+    __m128i special = _mm_or_si128(_mm_or_si128(
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('(')),
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(')'))),
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(';')));
+
+    // '\t' '\n' '\v' '\f' '\r' are the range 9 to 13
+    __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(9));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    __m128i space = _mm_or_si128(control, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+
+    specials = static_cast<std::uint32_t>(_mm_movemask_epi8(special));
+    delimiters = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(special, space)));
+}
+
+void scan_sse2(const char* source, std::size_t size, ScanState& state, TokenViewSequenceType& tokens) {
+    std::size_t pos = 0;
+    while (pos + 16 <= size) {
+        std::uint32_t delimiters, specials;
+        masks_sse2(source + pos, delimiters, specials);
+        pos = scan_block(source, size, pos, 16, delimiters, specials, state, tokens);
+    }
+    scan_scalar(source, size, pos, state, tokens);
+}
+
+// delimiter and special masks of 32 bytes
+__attribute__((target("avx2")))
+inline void masks_avx2(const char* block, std::uint32_t& delimiters, std::uint32_t& specials) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+
+    __m256i special = _mm256_or_si256(_mm256_or_si256(
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('(')),
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(')'))),
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(';')));
+
+    __m256i shifted = _mm256_sub_epi8(bytes, _mm256_set1_epi8(9));
+    __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    __m256i space = _mm256_or_si256(control, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+
+    specials = static_cast<std::uint32_t>(_mm256_movemask_epi8(special));
+    delimiters = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(special, space)));
+}
+
+__attribute__((target("avx2")))
+void scan_avx2(const char* source, std::size_t size, ScanState& state, TokenViewSequenceType& tokens) {
+    std::size_t pos = 0;
+    while (pos + 32 <= size) {
+        std::uint32_t delimiters, specials;
+        masks_avx2(source + pos, delimiters, specials);
+        pos = scan_block(source, size, pos, 32, delimiters, specials, state, tokens);
+    }
+    scan_scalar(source, size, pos, state, tokens);
+}
+
+#endif
+
+} // namespace
+
+TokenScanner best_token_scanner() {
+#ifdef TOKENIZER_HAVE_X86
+    static const TokenScanner best = __builtin_cpu_supports("avx2") ? AVX2Scanner : SSE2Scanner;
+    return best;
+#else
+    return ScalarScanner;
+#endif
+}
+
+// Buffer tokenizer implementation
+void tokenize(const char* source, std::size_t size, TokenViewSequenceType& tokens) {
+    tokenize(source, size, tokens, best_token_scanner());
+}
+
+void tokenize(const char* source, std::size_t size, TokenViewSequenceType& tokens, TokenScanner scanner) {
+    ScanState state;
+
+    // never use a scanner the CPU does not support
+    if (scanner > best_token_scanner()) {
+        scanner = best_token_scanner();
+    }
+
+    switch (scanner) {
+#ifdef TOKENIZER_HAVE_X86
+    case AVX2Scanner:
+        scan_avx2(source, size, state, tokens);
+        break;
+    case SSE2Scanner:
+        scan_sse2(source, size, state, tokens);
+        break;
+#endif
+    default:
+        scan_scalar(source, size, 0, state, tokens);
+        break;
+    }
+
+    if (state.in_atom) { // add any remaining token
+        tokens.push_back(Token{ state.start, size - state.start, AtomToken });
+    }
+}
@@ -2,10 +2,13 @@
 #define TOKENIZER_H
 
 #include <deque>
+#include <vector>
+#include <string>
+#include <cstddef>
 #include <iostream>
 #include <sstream>
 #include <cctype>
-#include <limits> 
+#include <limits>
 #include <algorithm>
 
 typedef std::deque<std::string> TokenSequenceType;
@@ -15,4 +18,31 @@ typedef std::deque<std::string> TokenSequenceType;
 // ignores any whitespace and from any ";" to end-of-line
 TokenSequenceType tokenize(std::istream &seq);
 
+// kind of a token found by the buffer tokenizer
+enum TokenKind { OpenToken, CloseToken, AtomToken };
+
+// a token is a range into the source buffer, it does not own any text
+struct Token {
+    std::size_t offset;
+    std::size_t length;
+    TokenKind kind;
+};
+
+typedef std::vector<Token> TokenViewSequenceType;
+
+// same rules as tokenize above, but scans a contiguous buffer and
+// appends (offset, length, kind) tokens to tokens without copying any text
+void tokenize(const char* source, std::size_t size, TokenViewSequenceType& tokens);
+
+// byte classifiers for the buffer tokenizer, all produce the same tokens.
+// The SIMD scanners classify 16 or 32 bytes at a time, tokenize uses the
+// fastest one the CPU supports
+enum TokenScanner { ScalarScanner, SSE2Scanner, AVX2Scanner };
+
+// fastest scanner supported by this CPU
+TokenScanner best_token_scanner();
+
+// tokenize with a given scanner, or the best supported one if it is not available
+void tokenize(const char* source, std::size_t size, TokenViewSequenceType& tokens, TokenScanner scanner);
+
 #endif
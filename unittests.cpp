@@ -4,11 +4,21 @@
 
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 #include "interpreter_semantic_error.hpp"
 #include "interpreter.hpp"
 #include "expression.hpp"
+#include "ast.hpp"
 #include "tokenizer.hpp"
+#include "form_reader.hpp"
+#include "list_kernels.hpp"
+#include "keywords.hpp"
+#include "test_config.hpp"
 
 
 // This is example unit test case with Catch 2
@@ -519,6 +529,289 @@ TEST_CASE("Test Interpreter 'begin' used incorrectly", "[interpreter]") {
     }
 }
 
+// evaluate program with the given mode, the result or the error message
+static std::string run_mode(const std::string& program, EvalMode mode) {
+    std::istringstream iss(program);
+    Interpreter interpreter;
+    interpreter.setEvalMode(mode);
+    if (!interpreter.parse(iss)) {
+        return "parse error";
+    }
+    try {
+        // evaluating twice reuses the compiled program
+        interpreter.eval();
+        return interpreter.eval().toString();
+    }
+    catch (const InterpreterSemanticError& err) {
+        return err.what();
+    }
+}
+
+TEST_CASE("Test bytecode VM matches the tree walker", "[interpreter][bytecode]") {
+    std::vector<std::string> programs = {
+        "(1 2 +)",
+        "(((1 2 +) 3 *) 4 /)",
+        "((x 10 define) (x 2 *) begin)",
+        "((a 1 define) (b 2 define) ((a b <) b a if) begin)",
+        "((a 1 define) (b 2 define) ((a b >) b a if) begin)",
+        "((a True define) (b a define) (a b and) begin)",
+        "(((0 0 point) (10 10 point) line) draw)",
+        "((((0 0 point) (10 10 point) rect) 1 2 3 fill_rect) draw)",
+        "((pi 3 /) sin)",
+        "(True)",
+        "(pi)",
+        // errors, the same message at the same point
+        "(1 0 /)",
+        "(x 1 +)",
+        "(1 2 (x 1 define) if)",
+        "((1 2 <) 1 (1 0 /) if)",
+        "((1 2 >) 1 (1 0 /) if)",
+        "(1 2 3 if)",
+        "(1 2 3 define)",
+        "(1 2 define)",
+        "(pi 2 define)",
+        "(1 2 pi)",
+        "((1 0 /) (undefined_z 1 +) +)",
+        "(+ 1 define)",
+    };
+
+    for (const auto& program : programs) {
+        REQUIRE(run_mode(program, BytecodeMode) == run_mode(program, TreeWalkMode));
+    }
+
+    for (const std::string file : { "/test2.slp", "/test3.slp", "/test4.slp", "/test5.slp", "/test_arc_simple.slp", "/test_crlf.slp" }) {
+        std::ifstream ifs(TEST_FILE_DIR + file);
+        std::string program((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        REQUIRE(run_mode(program, BytecodeMode) == run_mode(program, TreeWalkMode));
+    }
+}
+
+// evaluate program without exceptions, the result or the error message in
+// the form parseAndEvaluate reports it
+static std::string try_mode(const std::string& program, EvalMode mode) {
+    Interpreter interpreter;
+    interpreter.setEvalMode(mode);
+    EvalResult result = interpreter.tryParseAndEvaluate(program);
+    if (result.ok()) {
+        return result.value.toString();
+    }
+    return result.error.parseError() ? "Parsing failed" : result.error.message();
+}
+
+TEST_CASE("Test error-returning API matches the throwing one", "[interpreter][errors]") {
+    std::vector<std::string> programs = {
+        "(1 2 +)",
+        "(1 0 /)",
+        "(x 1 +)",
+        "(1 2 foo)",
+        "(1 2",
+        "1 2",
+        "(1 true +)",
+        "((1 2 3 range) (1 2 range) +)",
+        "(1 2 3 if)",
+        "(pi 2 define)",
+        "(+ 1 define)",
+        "((x 1 define) (x 2 +) begin)",
+        "(((0 0 point) (1 1 point) rect) 1 2 300 fill_rect)",
+    };
+
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        for (const auto& program : programs) {
+            Interpreter interpreter;
+            interpreter.setEvalMode(mode);
+            std::string expected;
+            try {
+                expected = interpreter.parseAndEvaluate(program).toString();
+            }
+            catch (const InterpreterSemanticError& err) {
+                expected = err.what();
+            }
+            REQUIRE(try_mode(program, mode) == expected);
+        }
+    }
+}
+
+TEST_CASE("Test error-returning API error codes", "[interpreter][errors]") {
+    Interpreter interpreter;
+
+    EvalResult result = interpreter.tryParseAndEvaluate("(x 1 +)");
+    REQUIRE_FALSE(result.ok());
+    REQUIRE(result.error.code == UnboundSymbolError);
+    REQUIRE_FALSE(result.error.parseError());
+    REQUIRE(result.error.message() == "Error: Symbol 'x' not found");
+
+    result = interpreter.tryParseAndEvaluate("(1 0 /)");
+    REQUIRE(result.error.code == ArgumentError);
+    REQUIRE(result.error.message() == "Error in call to divide: division by zero");
+
+    result = interpreter.tryParseAndEvaluate("(1 2 foo)");
+    REQUIRE(result.error.code == UnrecognizedKeywordError);
+    REQUIRE(result.error.parseError());
+    REQUIRE(result.error.message() == "Error: Unrecognized keyword 'foo'");
+
+    EvalError error;
+    REQUIRE_FALSE(interpreter.tryParse("(1 2", error));
+    REQUIRE(error.code == SyntaxError);
+    REQUIRE(error.message() == "Error: Mismatched parentheses");
+
+    // a failed form leaves the interpreter usable
+    REQUIRE(interpreter.tryParse("((y 2 define) (y 3 *) begin)", error));
+    result = interpreter.tryEval();
+    REQUIRE(result.ok());
+    REQUIRE(result.value == Expression(6.));
+}
+
+TEST_CASE("Test constant folding keeps results and errors", "[interpreter]") {
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        REQUIRE(run_mode("(((1 2 +) 3 *) 4 /)", mode) == "(2.25)");
+        REQUIRE(run_mode("((pi 2 /) sin)", mode) == "(1)");
+        REQUIRE(run_mode("((0 0 point) (3 4 point) line)", mode) == Expression(std::make_tuple(0., 0.), std::make_tuple(3., 4.)).toString());
+        REQUIRE(run_mode("(((0 0 point) draw) ((1 1 point) draw) begin)", mode) == "(1,1)");
+
+        // calls that fail are left to fail at eval time
+        REQUIRE(run_mode("((1 0 /) 1 +)", mode) == "Error in call to divide: division by zero");
+        REQUIRE(run_mode("((1 2 <) 1 (1 0 /) if)", mode) == "(1)");
+        REQUIRE(run_mode("((x 2 define) (x (1 -1 sqrt) +) begin)", mode) == "Error in call to sqrt, invalid argument");
+
+        // operands that are not constant are evaluated as before
+        REQUIRE(run_mode("((x 2 define) ((x 1 +) (2 3 *) *) begin)", mode) == "(18)");
+        REQUIRE(run_mode("((2 3 +) y *)", mode) == "Error: Symbol 'y' not found");
+
+        // lists are built at eval time, not for a branch never taken
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(run_mode("(False (0 200000000 range) 1 if)", mode) == "(1)");
+        }
+        REQUIRE(run_mode("(True (0 3 range) 1 if)", mode) == "(0 1 2)");
+    }
+}
+
+// depth nested lists: ((... (1 begin) ...) begin) and ((x 1 define) (((x 1 +) 1 +) ... 1 +) begin)
+static std::string nested_begin(size_t depth) {
+    std::string program = std::string(depth, '(') + "1";
+    for (size_t i = 0; i < depth; ++i) {
+        program += " begin)";
+    }
+    return program;
+}
+
+static std::string nested_sum(size_t depth) {
+    std::string program = "((x 1 define) " + std::string(depth, '(') + "x";
+    for (size_t i = 0; i < depth; ++i) {
+        program += " 1 +)";
+    }
+    return program + " begin)";
+}
+
+TEST_CASE("Test Interpreter with deeply nested input", "[interpreter][stress]") {
+    const size_t depth = 1000000;
+
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        Interpreter interpreter;
+        interpreter.setEvalMode(mode);
+
+        std::istringstream begins(nested_begin(depth));
+        REQUIRE(interpreter.parse(begins));
+        REQUIRE(interpreter.eval() == Expression(1.));
+
+        std::istringstream sums(nested_sum(depth));
+        REQUIRE(interpreter.parse(sums));
+        REQUIRE(interpreter.eval() == Expression(depth + 1.));
+    }
+}
+
+TEST_CASE("Test Interpreter depth limit", "[interpreter]") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.maxDepth() >= 1000000);
+
+    interpreter.setMaxDepth(100);
+    std::istringstream shallow(nested_begin(99));
+    REQUIRE(interpreter.parse(shallow));
+    REQUIRE(interpreter.eval() == Expression(1.));
+
+    std::istringstream deep(nested_begin(101));
+    REQUIRE_FALSE(interpreter.parse(deep));
+
+    // the limit also applies to an AST parsed under a larger one
+    interpreter.setMaxDepth(1000);
+    std::istringstream sums(nested_sum(500));
+    REQUIRE(interpreter.parse(sums));
+    interpreter.setMaxDepth(100);
+    REQUIRE_THROWS_AS(interpreter.eval(), InterpreterSemanticError);
+}
+
+TEST_CASE("Test Interpreter result cache", "[interpreter][cache]") {
+    Interpreter interpreter;
+
+    // off by default
+    REQUIRE(interpreter.parseAndEvaluate("(1 2 +)") == Expression(3.));
+    REQUIRE(interpreter.parseAndEvaluate("(1 2 +)") == Expression(3.));
+    REQUIRE(interpreter.cacheMisses() == 0);
+    REQUIRE(interpreter.cacheHits() == 0);
+
+    interpreter.setResultCache(true);
+    REQUIRE(interpreter.parseAndEvaluate("(x 2 define)") == Expression(2.));
+    REQUIRE(interpreter.parseAndEvaluate("((x 3 *) (0 0 point) begin)") == Expression(std::make_tuple(0., 0.)));
+    REQUIRE(interpreter.parseAndEvaluate("(x 3 *)") == Expression(6.));
+    REQUIRE(interpreter.cacheHits() == 0);
+    REQUIRE(interpreter.cacheMisses() == 3);
+
+    // the same tokens hit, whatever the spacing and comments
+    REQUIRE(interpreter.parseAndEvaluate("(x 3 *)") == Expression(6.));
+    REQUIRE(interpreter.parseAndEvaluate("( x\n 3 ; times\n * )") == Expression(6.));
+    REQUIRE(interpreter.cacheHits() == 2);
+
+    // defining a symbol the form does not read keeps the result
+    interpreter.parseAndEvaluate("(y 1 define)");
+    REQUIRE(interpreter.parseAndEvaluate("(x 3 *)") == Expression(6.));
+    REQUIRE(interpreter.cacheHits() == 3);
+
+    // redefining one it reads does not, even to the same value
+    interpreter.parseAndEvaluate("(x 4 define)");
+    REQUIRE(interpreter.parseAndEvaluate("(x 3 *)") == Expression(12.));
+    interpreter.parseAndEvaluate("(x 4 define)");
+    REQUIRE(interpreter.parseAndEvaluate("(x 3 *)") == Expression(12.));
+    REQUIRE(interpreter.cacheHits() == 3);
+
+    // forms that define are always evaluated
+    size_t misses = interpreter.cacheMisses();
+    interpreter.parseAndEvaluate("(z 1 define)");
+    interpreter.parseAndEvaluate("(z 1 define)");
+    REQUIRE(interpreter.cacheMisses() == misses + 2);
+
+    // errors are not cached
+    REQUIRE_THROWS_AS(interpreter.parseAndEvaluate("(w 1 +)"), InterpreterSemanticError);
+    interpreter.parseAndEvaluate("(w 1 define)");
+    REQUIRE(interpreter.parseAndEvaluate("(w 1 +)") == Expression(2.));
+
+    interpreter.setResultCache(false);
+    size_t hits = interpreter.cacheHits();
+    REQUIRE(interpreter.parseAndEvaluate("(x 3 *)") == Expression(12.));
+    REQUIRE(interpreter.cacheHits() == hits);
+}
+
+TEST_CASE("Test a cache hit is the program eval runs", "[interpreter][cache]") {
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        Interpreter interpreter;
+        interpreter.setEvalMode(mode);
+        interpreter.setResultCache(true);
+
+        REQUIRE(interpreter.parseAndEvaluate("(1 2 +)") == Expression(3.));
+        REQUIRE(interpreter.parseAndEvaluate("(5 5 *)") == Expression(25.));
+
+        // a hit on the input as entered before
+        REQUIRE(interpreter.parseAndEvaluate("(1 2 +)") == Expression(3.));
+        REQUIRE(interpreter.cacheHits() == 1);
+        REQUIRE(interpreter.eval() == Expression(3.));
+
+        // and on its tokens with other spacing
+        REQUIRE(interpreter.parseAndEvaluate("(5 5 *)") == Expression(25.));
+        REQUIRE(interpreter.parseAndEvaluate("( 1 2 + )") == Expression(3.));
+        REQUIRE(interpreter.cacheHits() == 3);
+        REQUIRE(interpreter.eval() == Expression(3.));
+        REQUIRE(interpreter.tryEval().value == Expression(3.));
+    }
+}
+
 // expression tests
 TEST_CASE("Test Type Inference", "[types]") {
     Atom a;
@@ -556,6 +849,44 @@ TEST_CASE("Test Type Inference", "[types]") {
     REQUIRE(a.type == SymbolType);
     REQUIRE(a.value.sym_value == token);
 }
+TEST_CASE("Test numeric literal scanning", "[types]") {
+    Atom a;
+
+    std::vector<std::pair<std::string, double>> numbers = {
+        { "0", 0. }, { "-0", -0. }, { "+1", 1. }, { "1.", 1. }, { ".5", .5 }, { "-.5", -.5 },
+        { "1e5", 1e5 }, { "1E+5", 1e5 }, { "-1.5e-3", -1.5e-3 }, { "00012", 12. },
+        { "0.1", 0.1 }, { "0.3", 0.3 }, { "3.14159265358979323846", 3.14159265358979323846 },
+        { "9007199254740993", 9007199254740992. }, { "123456789012345678901234567890", 123456789012345678901234567890. },
+        { "1.7976931348623157e308", 1.7976931348623157e308 }, { "4.9e-324", 4.9e-324 }, { "1e-999", 0. },
+    };
+    for (const auto& number : numbers) {
+        REQUIRE(token_to_atom(number.first, a));
+        REQUIRE(a.type == NumberType);
+        REQUIRE(a.value.num_value == number.second);
+        REQUIRE(std::signbit(a.value.num_value) == std::signbit(number.second));
+    }
+
+    // numbers followed by other characters or out of range are invalid
+    std::vector<std::string> invalid = { "1abc", "-1abc", "1e", "1e+", "1ex", "1.5.3", "0x10", "1e999", "-1e999", "1..", "1_" };
+    for (const auto& token : invalid) {
+        REQUIRE_FALSE(token_to_atom(token, a));
+    }
+
+    // anything without a leading number is a symbol
+    std::vector<std::string> symbols = { "+", "-", ".", "-.", "e5", "inf", "nan", "++1", "+-1", "x1" };
+    for (const auto& token : symbols) {
+        REQUIRE(token_to_atom(token, a));
+        REQUIRE(a.type == SymbolType);
+        REQUIRE(a.value.sym_value == token);
+    }
+
+    // scan_number reports the length of the number prefix
+    double value;
+    REQUIRE(scan_number("12.5e2)", 7, value) == 6);
+    REQUIRE(value == 1250.);
+    REQUIRE(scan_number("2e", 2, value) == 1);
+    REQUIRE(scan_number("abc", 3, value) == 0);
+}
 
 TEST_CASE("Test Expression Constructors", "[types]") {
     Expression exp1;
@@ -563,6 +894,487 @@ TEST_CASE("Test Expression Constructors", "[types]") {
     REQUIRE(exp1 == Expression());
 }
 
+TEST_CASE("Test compact Atom layout", "[types]") {
+    // the value members share storage, the largest is a filled rectangle
+    REQUIRE(sizeof(Value) == sizeof(FillRectt));
+    REQUIRE(sizeof(Atom) <= 64);
+
+    Expression fill(Rectt{ { 0, 0 }, { 10, 10 } }, 200, 100, 50);
+    Expression copy = fill;
+    REQUIRE(copy == fill);
+    REQUIRE(copy.head.value.fill_rect_value.rect.point2.x == 10);
+    REQUIRE(copy.head.value.fill_rect_value.b == 50);
+
+    Expression sym(std::string("abc"));
+    Expression same(std::string("abc"));
+    REQUIRE(sym == same);
+    REQUIRE_FALSE(sym == Expression(std::string("abd")));
+    REQUIRE(sym.toString() == "(abc)");
+}
+
+
+TEST_CASE("Test SymbolTable interning", "[types]") {
+    SymbolTable& table = SymbolTable::global();
+
+    // keywords have fixed ids
+    REQUIRE(table.intern("define") == DefineId);
+    REQUIRE(table.intern("begin") == BeginId);
+    REQUIRE(table.intern("if") == IfId);
+    REQUIRE(table.intern("+") == AddId);
+    REQUIRE(table.intern("draw") == DrawId);
+    REQUIRE(table.name(FillRectId) == "fill_rect");
+
+    // the same name always maps to the same id
+    SymbolId id = table.intern("some_user_symbol");
+    REQUIRE(id >= KeywordCount);
+    REQUIRE(table.intern(std::string("some_user_symbol")) == id);
+    REQUIRE(table.intern("some_user_symbol_x", 16) == id);
+    REQUIRE(table.name(id) == "some_user_symbol");
+
+    Symbol sym("some_user_symbol");
+    REQUIRE(sym.id == id);
+    REQUIRE(sym == Symbol::fromId(id));
+    REQUIRE(sym == "some_user_symbol");
+    REQUIRE_FALSE(sym.isKeyword());
+    REQUIRE(Symbol("pi").isKeyword());
+    REQUIRE_FALSE(Symbol().isKeyword());
+
+    Atom a;
+    REQUIRE(token_to_atom("some_user_symbol", a));
+    REQUIRE(a.value.sym_value.id == id);
+}
+
+TEST_CASE("Test SymbolTable interning from several threads", "[types]") {
+    SymbolTable& table = SymbolTable::global();
+
+    // more names than a chunk holds, each thread in another order
+    const std::size_t count = 2 * SymbolTable::ChunkSize + 100;
+    std::vector<std::vector<SymbolId>> ids(4, std::vector<SymbolId>(count));
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < ids.size(); ++t) {
+        threads.emplace_back([&ids, &table, t, count]() {
+            for (std::size_t k = 0; k < count; ++k) {
+                std::size_t i = t % 2 ? count - 1 - k : k;
+                std::string name = "threaded_symbol_" + std::to_string(i);
+                ids[t][i] = table.intern(name);
+                if (table.name(ids[t][i]) != name) {
+                    ids[t][i] = EmptyId;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        REQUIRE(ids[0][i] >= KeywordCount);
+        for (std::size_t t = 1; t < ids.size(); ++t) {
+            REQUIRE(ids[t][i] == ids[0][i]);
+        }
+        REQUIRE(table.name(ids[0][i]) == "threaded_symbol_" + std::to_string(i));
+    }
+    REQUIRE(table.size() >= KeywordCount + count);
+}
+
+TEST_CASE("Test perfect hash keyword lookup", "[types]") {
+    // every keyword maps to its own id
+    for (SymbolId id = EmptyId + 1; id < KeywordCount; ++id) {
+        std::string name = keyword_names[id];
+        REQUIRE(find_keyword(name.data(), name.size()) == id);
+        REQUIRE(Symbol(name).id == id);
+    }
+
+    // near misses are not keywords
+    for (const char* name : {"", "defin", "definex", "Pi", "x", "true", "ifx", "draw_", "++", "<<"}) {
+        REQUIRE(find_keyword(name, std::strlen(name)) == KeywordCount);
+    }
+
+    // only the first length characters count
+    REQUIRE(find_keyword("define)", 6) == DefineId);
+    REQUIRE(find_keyword("begin (", 5) == BeginId);
+
+    // keyword tokens classify the same as interned ones
+    Atom a;
+    REQUIRE(token_to_atom("True", a));
+    REQUIRE(a.type == BooleanType);
+    REQUIRE(a.value.bool_value);
+    REQUIRE(token_to_atom("False", a));
+    REQUIRE(a.type == BooleanType);
+    REQUIRE_FALSE(a.value.bool_value);
+    REQUIRE(token_to_atom("sqrt", a));
+    REQUIRE(a.type == SymbolType);
+    REQUIRE(a.value.sym_value.id == SqrtId);
+}
+
+TEST_CASE("Test Environment bindings by symbol id", "[environment]") {
+    Environment env;
+
+    REQUIRE(env.isProcedure(Symbol::fromId(AddId)));
+    REQUIRE(env.get(Symbol::fromId(PiId)) == Expression(std::atan2(0, -1)));
+    REQUIRE_FALSE(env.isDefined(Symbol::fromId(DefineId)));
+    REQUIRE_FALSE(env.isDefined(Symbol("x")));
+
+    env.define(Symbol("x"), Expression(2.));
+    REQUIRE(env.isDefined(Symbol("x")));
+    REQUIRE(env.get(Symbol("x")) == Expression(2.));
+    REQUIRE_THROWS_AS(env.get(Symbol("undefined_y")), InterpreterSemanticError);
+    REQUIRE_THROWS_AS(env.get(Symbol::fromId(SinId)), InterpreterSemanticError);
+
+    env.reset();
+    REQUIRE_FALSE(env.isDefined(Symbol("x")));
+}
+
+TEST_CASE("Test Environments share the builtin table", "[environment]") {
+    Environment first;
+    Environment second;
+    REQUIRE(first.builtins == second.builtins);
+    REQUIRE(first.envmap.empty());
+
+    // a keyword redefined in one environment keeps its builtin in the others
+    first.define(Symbol("+"), [](Environment&, const std::vector<Atom>&) { return Expression(0.); });
+    first.define(Symbol("pi"), Expression(3.));
+    REQUIRE(first.getProcedure(Symbol("+")) == nullptr);
+    REQUIRE(first.get(Symbol("pi")) == Expression(3.));
+    REQUIRE(second.getProcedure(Symbol("+")) != nullptr);
+    REQUIRE(second.get(Symbol("pi")) == Expression(std::atan2(0, -1)));
+
+    std::uint64_t stamp = first.stamp(Symbol("pi"));
+    first.reset();
+    REQUIRE(first.envmap.empty());
+    REQUIRE(first.getProcedure(Symbol("+")) == second.getProcedure(Symbol("+")));
+    REQUIRE(first.get(Symbol("pi")) == second.get(Symbol("pi")));
+    REQUIRE(first.stamp(Symbol("pi")) != stamp);
+}
+
+TEST_CASE("Test Environment resolves builtins to direct procedures", "[environment]") {
+    Environment env;
+
+    Procedure add = env.getProcedure(Symbol("+"));
+    REQUIRE(add != nullptr);
+    std::vector<Atom> args = { Expression(1.).head, Expression(2.).head };
+    Atom result;
+    EvalError error;
+    REQUIRE(add(args, result, error));
+    REQUIRE(Expression(result) == Expression(3.));
+    REQUIRE(env.getProcedure(Symbol("pi")) == nullptr);
+    REQUIRE(env.getProcedure(Symbol("x")) == nullptr);
+
+    // plain definitions keep resolved procedures valid
+    std::uint64_t version = env.version();
+    env.define(Symbol("x"), Expression(2.));
+    REQUIRE(env.version() == version);
+
+    // rebinding a procedure invalidates them
+    env.define(Symbol("+"), [](Environment&, const std::vector<Atom>&) { return Expression(0.); });
+    REQUIRE(env.version() != version);
+    REQUIRE(env.isProcedure(Symbol("+")));
+    REQUIRE(env.getProcedure(Symbol("+")) == nullptr);
+
+    version = env.version();
+    env.reset();
+    REQUIRE(env.version() != version);
+    REQUIRE(env.getProcedure(Symbol("+")) == add);
+}
+
+TEST_CASE("Test Environment call types", "[environment][types]") {
+    Environment env;
+    Procedure unchecked;
+
+    // proved argument types give the variant without checks
+    Type numbers[] = { NumberType, NumberType, NumberType, NumberType };
+    REQUIRE(env.callType(Symbol("+"), numbers, 3, unchecked) == NumberType);
+    REQUIRE(unchecked != nullptr);
+    REQUIRE(unchecked != env.getProcedure(Symbol("+")));
+    REQUIRE(env.callType(Symbol("line"), numbers, 4, unchecked) == LineType);
+    REQUIRE(unchecked != nullptr);
+
+    // unknown or wrong types keep the checks, the result type may still be known
+    Type mixed[] = { NumberType, NoneType };
+    REQUIRE(env.callType(Symbol("+"), mixed, 2, unchecked) == NoneType);
+    REQUIRE(unchecked == nullptr);
+    REQUIRE(env.callType(Symbol("<"), mixed, 2, unchecked) == BooleanType);
+    REQUIRE(unchecked == nullptr);
+    REQUIRE(env.callType(Symbol("point"), mixed, 2, unchecked) == PointType);
+    REQUIRE(unchecked == nullptr);
+    Type booleans[] = { BooleanType, BooleanType };
+    REQUIRE(env.callType(Symbol("+"), booleans, 2, unchecked) == NoneType);
+    REQUIRE(unchecked == nullptr);
+    REQUIRE(env.callType(Symbol("-"), numbers, 3, unchecked) == NoneType);
+    REQUIRE(unchecked == nullptr);
+
+    // a builtin the host rebinds has no known type
+    env.define(Symbol("+"), [](Environment&, const std::vector<Atom>&) { return Expression(0.); });
+    REQUIRE(env.callType(Symbol("+"), numbers, 3, unchecked) == NoneType);
+    REQUIRE(unchecked == nullptr);
+}
+
+TEST_CASE("Test type inference keeps results and errors", "[interpreter][types]") {
+    std::vector<std::pair<std::string, std::string>> programs = {
+        // types proved from literals and defined constants
+        { "((a 3 define) (b 4 define) ((a a *) (b b *) +) begin)", "(25)" },
+        { "((a 1 define) (b 2 define) ((a b <) (a b -) (a b /) if) begin)", "(-1)" },
+        { "((p (1 2 point) define) (q (3 4 point) define) ((p q rect) 10 20 30 fill_rect) begin)", "((1,2),(3,4) (10,20,30))" },
+        { "((x 2 define) ((x 1 +) 3 -) begin)", "(0)" },
+        // value checks are still made
+        { "((a 1 define) (b 0 define) (a b /) begin)", "Error in call to divide: division by zero" },
+        { "((a -1 define) (a sqrt) begin)", "Error in call to sqrt, invalid argument" },
+        { "((r ((0 0 point) (1 1 point) rect) define) (r 300 0 0 fill_rect) begin)", "Color values must be in the range [0, 255]" },
+        // types not proved report the same errors
+        { "((a True define) (a 1 +) begin)", "Error in call to add, argument not a number" },
+        { "((a 1 define) (a 1 +) (a True define) (a 1 +) begin)", "Error in call to add, argument not a number" },
+        { "((a 1 define) (b (a True and) define) b begin)", "Error in call to and: argument not a boolean" },
+        { "((a (0 3 range) define) (a 1 +) begin)", "(1 2 3)" },
+        { "((a (True 1 False if) define) (a 1 +) begin)", "(2)" },
+    };
+
+    for (const auto& program : programs) {
+        INFO(program.first);
+        REQUIRE(run_mode(program.first, TreeWalkMode) == program.second);
+        REQUIRE(run_mode(program.first, BytecodeMode) == program.second);
+    }
+}
+
+TEST_CASE("Test define requires a symbol", "[interpreter]") {
+    std::istringstream iss("(1 2 define)");
+    Interpreter interpreter;
+    REQUIRE(interpreter.parse(iss));
+    REQUIRE_THROWS_AS(interpreter.eval(), InterpreterSemanticError);
+}
+
+TEST_CASE("Test flat Ast", "[types]") {
+    Ast ast;
+    REQUIRE(ast.empty());
+
+    // ((1 2 +) x *) in postfix order
+    std::uint32_t one = ast.add(Expression(1.).head, nullptr, 0);
+    std::uint32_t two = ast.add(Expression(2.).head, nullptr, 0);
+    std::uint32_t sum_children[] = { one, two };
+    std::uint32_t sum = ast.add(Expression(std::string("+")).head, sum_children, 2);
+    std::uint32_t x = ast.add(Expression(std::string("x")).head, nullptr, 0);
+    std::uint32_t product_children[] = { sum, x };
+    std::uint32_t product = ast.add(Expression(std::string("*")).head, product_children, 2);
+
+    REQUIRE(ast.root() == product);
+    REQUIRE(ast.nodes[product].count == 2);
+    REQUIRE(&ast.child(ast.nodes[product], 0) == &ast.nodes[sum]);
+    REQUIRE(ast.child(ast.child(ast.nodes[product], 0), 1).head.value.num_value == 2.);
+
+    REQUIRE(ast.child(ast.nodes[product], 1).head.value.sym_value == Symbol("x"));
+
+    // clearing keeps the storage for the next form
+    std::size_t capacity = ast.nodes.capacity();
+    ast.clear();
+    REQUIRE(ast.empty());
+    REQUIRE(ast.nodes.capacity() == capacity);
+}
+
+// add the subtree (x y point) to ast
+static std::uint32_t add_point(Ast& ast, double x, double y) {
+    std::uint32_t coordinates[] = { ast.add(Expression(x).head, nullptr, 0), ast.add(Expression(y).head, nullptr, 0) };
+    return ast.add(Expression(std::string("point")).head, coordinates, 2);
+}
+
+TEST_CASE("Test hash-consed Ast", "[types]") {
+    Ast plain;
+    std::uint32_t a = add_point(plain, 0, 0);
+    std::uint32_t b = add_point(plain, 0, 0);
+    std::uint32_t c = add_point(plain, 0, -0.);
+    REQUIRE(a != b);
+    REQUIRE(plain.nodes[a].hash == plain.nodes[b].hash);
+    REQUIRE(plain.nodes[a].hash != plain.nodes[c].hash);
+
+    Ast shared;
+    shared.setSharing(true);
+    std::uint32_t first = add_point(shared, 0, 0);
+    std::size_t size = shared.nodes.size();
+    REQUIRE(add_point(shared, 0, 0) == first);
+    REQUIRE(shared.nodes.size() == size);
+    REQUIRE(add_point(shared, 0, 1) != first);
+
+    // (p p line) stores p once but has it as both children
+    std::uint32_t line_children[] = { first, first };
+    std::uint32_t line = shared.add(Expression(std::string("line")).head, line_children, 2);
+    REQUIRE(&shared.child(shared.nodes[line], 0) == &shared.child(shared.nodes[line], 1));
+    REQUIRE(shared.children[shared.nodes[line].first + 1] == first);
+
+    // replacing a node keeps hashes structural
+    shared.replace(first, Expression(1.).head);
+    shared.rehash(line);
+    REQUIRE(shared.nodes[first].hash == shared.nodes[shared.add(Expression(1.).head, nullptr, 0)].hash);
+
+    shared.clear();
+    REQUIRE(shared.sharing());
+    REQUIRE(add_point(shared, 0, 0) == 1); // 0 is stored once too
+
+    // graphics, as calls fold to, are compared by value
+    Atom point = Expression(std::make_tuple(1., 2.)).head;
+    std::uint32_t folded = add_point(shared, 1, 2);
+    std::uint32_t other = shared.add(Expression(std::string("x")).head, nullptr, 0);
+    shared.replace(folded, point);
+    REQUIRE(shared.add(point, nullptr, 0) == folded);
+    shared.replace(other, point);
+    REQUIRE(shared.nodes[folded].hash == shared.nodes[other].hash);
+    REQUIRE(shared.nodes[folded].hash != shared.nodes[shared.add(Expression(std::make_tuple(1., -2.)).head, nullptr, 0)].hash);
+    Atom segment = Expression(std::make_tuple(0., 0.), std::make_tuple(1., 2.)).head;
+    REQUIRE(shared.add(segment, nullptr, 0) == shared.add(segment, nullptr, 0));
+}
+
+TEST_CASE("Test Interpreter with shared subtrees", "[interpreter]") {
+    std::string program = "((((0 0 point) (10 10 point) line) draw) (((0 0 point) (10 10 point) line) draw) "
+        "(x 2 define) ((x x +) (x x +) *) begin)";
+
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        Interpreter interpreter;
+        interpreter.setEvalMode(mode);
+        interpreter.setSharedSubtrees(true);
+        std::istringstream iss(program);
+        REQUIRE(interpreter.parse(iss));
+        REQUIRE(interpreter.eval() == Expression(16.));
+        REQUIRE(run_mode(program, mode) == "(16)");
+    }
+}
+
+// a begin of many independent drawing children with a few defines and
+// children that read them, so it splits into several parallel waves
+static std::string parallel_program(const std::string& last) {
+    std::string program = "((a 1 define) ";
+    for (int i = 0; i < 100; ++i) {
+        std::string n = std::to_string(i);
+        program += "((((" + n + " a *) " + n + " point) (" + n + " 2 point) line) draw) ";
+        if (i % 40 == 39) {
+            program += "(a (a 1 +) define) (b" + n + " (a 2 *) define) ";
+        }
+    }
+    return program + last + " begin)";
+}
+
+// the result of program, or its error, followed by the values of symbols
+static std::string run_threads(const std::string& program, std::size_t threads, const std::vector<std::string>& symbols) {
+    Interpreter interpreter;
+    interpreter.setThreads(threads);
+    EvalResult result = interpreter.tryParseAndEvaluate(program);
+    std::string out = result.ok() ? result.value.toString() : result.error.message();
+    for (const auto& symbol : symbols) {
+        EvalResult value = interpreter.tryParseAndEvaluate("(" + symbol + " 0 +)");
+        out += " " + (value.ok() ? value.value.toString() : value.error.message());
+    }
+    return out;
+}
+
+TEST_CASE("Test parallel begin evaluation matches serial evaluation", "[interpreter][parallel]") {
+    std::vector<std::string> symbols = { "a", "b39", "b79", "c" };
+    std::vector<std::string> programs = {
+        parallel_program("(a b79 +)"),
+        parallel_program("(c (a b39 *) define)"),
+        // the first error in order wins, defines after it are not made
+        parallel_program("((1 0 /) (c 1 define) (x 1 +) (1 -1 sqrt))"),
+        parallel_program("(c 2 define) (1 true +) (c 3 define) (a 5 define)"),
+        parallel_program("(a 1 define) (a (a 1 +) define) (a (a 1 +) define) (a 10 *)"),
+    };
+
+    for (const auto& program : programs) {
+        std::string serial = run_threads(program, 1, symbols);
+        for (std::size_t threads : { 2, 4, 8 }) {
+            REQUIRE(run_threads(program, threads, symbols) == serial);
+        }
+    }
+
+    Interpreter interpreter;
+    interpreter.setThreads(4);
+    REQUIRE(interpreter.threads() == 4);
+    REQUIRE(interpreter.parseAndEvaluate(parallel_program("(a b79 +)")) == Expression(9.));
+    REQUIRE(interpreter.parseAndEvaluate("(a b79 +)") == Expression(9.));
+    interpreter.setThreads(1);
+    REQUIRE(interpreter.threads() == 1);
+}
+
+// the graphics drawn while evaluating program, as text
+static std::string drawn_mode(const std::string& program, EvalMode mode, std::size_t threads, std::size_t batch) {
+    Interpreter interpreter;
+    interpreter.setEvalMode(mode);
+    interpreter.setThreads(threads);
+    std::string out;
+    std::size_t batches = 0;
+    interpreter.geometry().setHandler(batch, [&](const std::vector<Atom>& graphics) {
+        REQUIRE(graphics.size() <= batch);
+        for (const Atom& graphic : graphics) {
+            out += Expression(graphic).toString() + " ";
+        }
+        ++batches;
+    });
+    EvalResult result = interpreter.tryParseAndEvaluate(program);
+    REQUIRE(batches == (interpreter.geometry().drawn() + batch - 1) / batch);
+    return out + "-> " + (result.ok() ? result.value.toString() : result.error.message());
+}
+
+TEST_CASE("Test draw sends every graphic to the geometry sink", "[interpreter][draw]") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.parseAndEvaluate("((0 0 point) ((1 1 point) (2 2 point) line) draw)") == Expression(std::make_tuple(1., 1.), std::make_tuple(2., 2.)));
+    REQUIRE(interpreter.geometry().drawn() == 2);
+    REQUIRE(interpreter.geometry().graphics().size() == 2);
+    REQUIRE(interpreter.geometry().graphics()[0].type == PointType);
+    REQUIRE(interpreter.geometry().graphics()[1].type == LineType);
+
+    // draw has effects, so the result cache does not skip it
+    interpreter.geometry().clear();
+    interpreter.parseAndEvaluate("((0 0 point) ((1 1 point) (2 2 point) line) draw)");
+    REQUIRE(interpreter.geometry().graphics().size() == 2);
+
+    // nothing is drawn by a failing draw
+    interpreter.geometry().clear();
+    REQUIRE_THROWS_AS(interpreter.parseAndEvaluate("((0 0 point) 1 draw)"), InterpreterSemanticError);
+    REQUIRE_THROWS_AS(interpreter.parseAndEvaluate("(draw)"), InterpreterSemanticError);
+    REQUIRE(interpreter.geometry().graphics().empty());
+
+    // every draw of a script, in order
+    for (const std::string file : { "/test_car.slp", "/test_airplane.slp" }) {
+        std::ifstream ifs(TEST_FILE_DIR + file);
+        std::string program((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        std::string expected = drawn_mode(program, TreeWalkMode, 1, 1000);
+        REQUIRE(expected.find("Error") == std::string::npos);
+        REQUIRE(drawn_mode(program, BytecodeMode, 1, 1000) == expected);
+        REQUIRE(drawn_mode(program, TreeWalkMode, 1, 3) == expected);
+    }
+
+    Interpreter car;
+    std::ifstream ifs(TEST_FILE_DIR + "/test_car.slp");
+    REQUIRE(car.parse(ifs));
+    car.eval();
+    REQUIRE(car.geometry().drawn() == 12);
+
+    // graphics drawn before an error are kept, as they may be shown already
+    REQUIRE(drawn_mode("(((0 0 point) draw) (1 0 /) ((1 1 point) draw) begin)", TreeWalkMode, 1, 4)
+        == "(0,0) -> Error in call to divide: division by zero");
+}
+
+TEST_CASE("Test parallel begin draws in order", "[interpreter][parallel][draw]") {
+    std::vector<std::string> programs = {
+        parallel_program("(a b79 +)"),
+        parallel_program("((1 0 /) (c 1 define) (x 1 +) (1 -1 sqrt))"),
+    };
+    for (const auto& program : programs) {
+        std::string serial = drawn_mode(program, TreeWalkMode, 1, 16);
+        REQUIRE(drawn_mode(program, TreeWalkMode, 4, 16) == serial);
+        REQUIRE(drawn_mode(program, BytecodeMode, 1, 16) == serial);
+    }
+}
+
+TEST_CASE("Test Interpreter reuses parse storage across forms", "[interpreter]") {
+    Interpreter interpreter;
+    std::istringstream good("((a 2 define) (a 3 *) begin)");
+    REQUIRE(interpreter.parse(good));
+    REQUIRE(interpreter.eval() == Expression(6.));
+
+    // a failed parse leaves nothing to evaluate
+    std::istringstream bad("((a 2 define) (a 3 *) begin");
+    REQUIRE_FALSE(interpreter.parse(bad));
+    REQUIRE(interpreter.eval() == Expression());
+
+    std::istringstream next("(a 1 +)");
+    REQUIRE(interpreter.parse(next));
+    REQUIRE(interpreter.eval() == Expression(3.));
+}
 
 // tokenizer tests
 TEST_CASE("Test Tokenizer with expected input", "[tokenize]") {
@@ -650,6 +1462,250 @@ TEST_CASE("Test Tokenizer with empty expression", "[tokenize]") {
 }
 
 
+TEST_CASE("Test buffer Tokenizer matches stream Tokenizer", "[tokenize]") {
+    std::vector<std::string> programs = {
+        "(begin (define r 10) (* pi (* r r)))",
+        "((x 10 define) ; comment (x 2 *)\r\n(x 2 *) begin)",
+        "(f",
+        "hello",
+        "",
+        "( )",
+        "  \t(1.5e3\t-2 +)\n",
+        "abc;comment\ndef",
+        "(1 2;c\n+)",
+    };
+
+    for (const auto& program : programs) {
+        std::istringstream iss(program);
+        TokenSequenceType expected = tokenize(iss);
+
+        TokenViewSequenceType tokens;
+        tokenize(program.data(), program.size(), tokens);
+
+        REQUIRE(tokens.size() == expected.size());
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            REQUIRE(program.substr(tokens[i].offset, tokens[i].length) == expected[i]);
+            if (expected[i] == "(") {
+                REQUIRE(tokens[i].kind == OpenToken);
+            }
+            else if (expected[i] == ")") {
+                REQUIRE(tokens[i].kind == CloseToken);
+            }
+            else {
+                REQUIRE(tokens[i].kind == AtomToken);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test a comment ends an atom", "[tokenize]") {
+    std::string program = "abc;comment\ndef";
+    std::istringstream iss(program);
+    TokenSequenceType expected = { "abc", "def" };
+    REQUIRE(tokenize(iss) == expected);
+
+    TokenViewSequenceType tokens;
+    tokenize(program.data(), program.size(), tokens);
+    REQUIRE(tokens.size() == 2);
+    REQUIRE(program.substr(tokens[0].offset, tokens[0].length) == "abc");
+    REQUIRE(program.substr(tokens[1].offset, tokens[1].length) == "def");
+}
+
+TEST_CASE("Test SIMD token scanners match the scalar scanner", "[tokenize]") {
+    std::vector<std::string> programs;
+
+    // every script in the tests directory, including the CRLF one
+    for (const std::string file : { "/test_crlf.slp", "/test_car.slp", "/test_airplane.slp", "/test4.slp" }) {
+        std::ifstream ifs(TEST_FILE_DIR + file);
+        programs.push_back(std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()));
+    }
+
+    // random text over the interesting characters, atoms and comments across block edges
+    const char alphabet[] = "ab1.-( );\n\r\t\v\f";
+    unsigned seed = 12345;
+    for (int n = 0; n < 200; ++n) {
+        std::string program;
+        for (int i = 0; i < n * 3; ++i) {
+            seed = seed * 1103515245 + 12345;
+            program += alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+        }
+        programs.push_back(program);
+    }
+
+    for (const auto& program : programs) {
+        TokenViewSequenceType expected;
+        tokenize(program.data(), program.size(), expected, ScalarScanner);
+
+        for (TokenScanner scanner : { SSE2Scanner, AVX2Scanner }) {
+            TokenViewSequenceType tokens;
+            tokenize(program.data(), program.size(), tokens, scanner);
+
+            REQUIRE(tokens.size() == expected.size());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                REQUIRE(tokens[i].offset == expected[i].offset);
+                REQUIRE(tokens[i].length == expected[i].length);
+                REQUIRE(tokens[i].kind == expected[i].kind);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test SIMD list kernels match the scalar kernel", "[lists]") {
+    unsigned seed = 12345;
+    for (size_t size = 0; size < 40; ++size) {
+        std::vector<double> a(size + 1), b(size + 1);
+        for (size_t i = 0; i <= size; ++i) {
+            seed = seed * 1103515245 + 12345;
+            a[i] = (seed >> 8) % 1000 / 7.0;
+            b[i] = (seed >> 4) % 1000 / 3.0 + 1;
+        }
+
+        for (ListOp op : { ListAdd, ListSubtract, ListMultiply, ListDivide }) {
+            for (int scalars = 0; scalars < 3; ++scalars) {
+                bool a_scalar = (scalars == 1), b_scalar = (scalars == 2);
+                std::vector<double> expected(size), out(size);
+                list_binary(op, a.data(), a_scalar, b.data(), b_scalar, expected.data(), size, ScalarKernel);
+                for (ListKernel kernel : { SSE2Kernel, AVXKernel }) {
+                    list_binary(op, a.data(), a_scalar, b.data(), b_scalar, out.data(), size, kernel);
+                    REQUIRE(out == expected);
+                }
+            }
+        }
+
+        std::vector<double> expected(size), out(size);
+        list_sqrt(a.data(), expected.data(), size, ScalarKernel);
+        for (ListKernel kernel : { SSE2Kernel, AVXKernel }) {
+            list_sqrt(a.data(), out.data(), size, kernel);
+            REQUIRE(out == expected);
+        }
+    }
+}
+
+TEST_CASE("Test List values", "[lists]") {
+    Expression numbers(std::vector<double>{ 1, 2, 3 });
+    REQUIRE(numbers.head.type == ListType);
+    REQUIRE(numbers.toString() == "(1 2 3)");
+
+    // copies share the storage, which lives as long as one of them
+    Expression copy = numbers;
+    REQUIRE(copy.head.value.list_value.storage == numbers.head.value.list_value.storage);
+    REQUIRE(numbers.head.value.list_value.storage->refs == 2);
+    numbers = Expression(1.);
+    REQUIRE(copy.head.value.list_value.storage->refs == 1);
+    REQUIRE(copy == Expression(std::vector<double>{ 1, 2, 3 }));
+    REQUIRE_FALSE(copy == Expression(std::vector<double>{ 1, 2 }));
+    REQUIRE_FALSE(copy == Expression(std::vector<double>{ 1, 2, 4 }));
+}
+
+TEST_CASE("Test Interpreter list builtins", "[interpreter][lists]") {
+    for (EvalMode mode : { TreeWalkMode, BytecodeMode }) {
+        REQUIRE(run_mode("(0 5 range)", mode) == "(0 1 2 3 4)");
+        REQUIRE(run_mode("(1 2 0.25 range)", mode) == "(1 1.25 1.5 1.75)");
+        REQUIRE(run_mode("(5 0 -2 range)", mode) == "(5 3 1)");
+        REQUIRE(run_mode("(0 0 range)", mode) == "()");
+        REQUIRE(run_mode("(0 1 5 linspace)", mode) == "(0 0.25 0.5 0.75 1)");
+        REQUIRE(run_mode("(2 4 1 linspace)", mode) == "(2)");
+
+        // element-wise arithmetic, numbers are broadcast
+        REQUIRE(run_mode("((0 4 range) (0 4 range) +)", mode) == "(0 2 4 6)");
+        REQUIRE(run_mode("((0 4 range) 10 1 +)", mode) == "(11 12 13 14)");
+        REQUIRE(run_mode("(10 (0 4 range) -)", mode) == "(10 9 8 7)");
+        REQUIRE(run_mode("((1 4 range) -)", mode) == "(-1 -2 -3)");
+        REQUIRE(run_mode("(2 (1 4 range) (1 4 range) *)", mode) == "(2 8 18)");
+        REQUIRE(run_mode("((1 4 range) 2 /)", mode) == "(0.5 1 1.5)");
+        REQUIRE(run_mode("(((0 5 range) (0 5 range) *) sqrt)", mode) == "(0 1 2 3 4)");
+        REQUIRE(run_mode("(((0 2 range) pi *) cos)", mode) == "(1 -1)");
+        REQUIRE(run_mode("((x (0 1 3 linspace) define) ((x pi *) sin) begin)", mode) == Expression(std::vector<double>{ 0, 1, std::sin(std::atan2(0, -1)) }).toString());
+
+        // errors
+        REQUIRE(run_mode("((0 3 range) (0 4 range) +)", mode) == "Error in call to add: lists of different sizes");
+        REQUIRE(run_mode("((0 3 range) True +)", mode) == "Error in call to add, argument not a number");
+        REQUIRE(run_mode("(1 (0 3 range) /)", mode) == "Error in call to divide: division by zero");
+        REQUIRE(run_mode("((-1 3 range) sqrt)", mode) == "Error in call to sqrt, invalid argument");
+        REQUIRE(run_mode("(0 1 0 range)", mode) == "Error in call to range: step is zero");
+        REQUIRE(run_mode("(0 1e300 range)", mode) == "Error in call to range: too many elements");
+        REQUIRE(run_mode("(0 1 0.5 linspace)", mode) == "Error in call to linspace: invalid count");
+    }
+}
+
+// form reader tests
+TEST_CASE("Test FormReader splits a stream into top-level forms", "[form_reader]") {
+    std::string program = "; leading comment\n(1 2 +)\r\n(\n (a 1 define) ; inner ( comment\n (a 2 *)\nbegin)  True x) (1";
+
+    // small chunks to exercise forms spanning several reads
+    for (size_t chunk : { 1, 3, 7, 4096 }) {
+        std::istringstream iss(program);
+        FormReader reader(iss, chunk);
+        std::string form;
+
+        REQUIRE(reader.next(form));
+        REQUIRE(form == "(1 2 +)");
+        REQUIRE(reader.bytesConsumed() == program.find(")") + 1);
+
+        REQUIRE(reader.next(form));
+        REQUIRE(form == "(\n (a 1 define) ; inner ( comment\n (a 2 *)\nbegin)");
+
+        REQUIRE(reader.next(form));
+        REQUIRE(form == "True");
+
+        REQUIRE(reader.next(form));
+        REQUIRE(form == "x");
+
+        REQUIRE(reader.next(form));
+        REQUIRE(form == ")");
+
+        REQUIRE(reader.next(form));
+        REQUIRE(form == "(1");
+
+        REQUIRE_FALSE(reader.next(form));
+        REQUIRE(reader.formsRead() == 6);
+        REQUIRE(reader.bytesConsumed() == program.size());
+    }
+}
+
+TEST_CASE("Test FormReader with empty and comment only input", "[form_reader]") {
+    std::string program = "  ; nothing here\n\t\n";
+    std::istringstream iss(program);
+    FormReader reader(iss);
+    std::string form;
+
+    REQUIRE_FALSE(reader.next(form));
+    REQUIRE(reader.formsRead() == 0);
+    REQUIRE(reader.bytesConsumed() == program.size());
+}
+
+TEST_CASE("Test Interpreter evaluates a stream form by form", "[interpreter][form_reader]") {
+    std::istringstream iss("(a 10 define)\n; comment\n(b (a 2 *) define)\n((a b +) sqrt)\n");
+    FormReader reader(iss);
+    Interpreter interpreter;
+
+    std::vector<Expression> results;
+    while (interpreter.parseNext(reader)) {
+        results.push_back(interpreter.eval());
+    }
+
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0] == Expression(10.));
+    REQUIRE(results[1] == Expression(20.));
+    REQUIRE(results[2] == Expression(std::sqrt(30.)));
+
+    std::istringstream bad("(1 2 +) (1 2");
+    FormReader bad_reader(bad);
+    REQUIRE(interpreter.parseNext(bad_reader));
+    REQUIRE_THROWS_AS(interpreter.parseNext(bad_reader), InterpreterSemanticError);
+}
+
+TEST_CASE("Test Interpreter parses multi-line script files", "[interpreter]") {
+    std::vector<std::string> files = { "/test_car.slp", "/test_airplane.slp", "/test_arc.slp", "/test_crlf.slp" };
+
+    for (const auto& file : files) {
+        std::ifstream ifs(TEST_FILE_DIR + file);
+        REQUIRE(ifs.good());
+        Interpreter interpreter;
+        REQUIRE(interpreter.parse(ifs));
+    }
+}
+
 // Testing interpreter
 TEST_CASE("Test Interpreter extra tests", "[interpreter]") {
     std::vector<std::string> programs = {
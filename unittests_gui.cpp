@@ -3,6 +3,9 @@
 #include <QtWidgets>
 
 #include "canvas_widget.hpp"
+#include "display_list_item.hpp"
+#include "headless_render.hpp"
+#include "spatial_index.hpp"
 #include "main_window.hpp"
 #include "message_widget.hpp"
 #include "repl_widget.hpp"
@@ -33,6 +36,11 @@ private slots:
     void testColorValidation();
     void testValidFillRectColors();
     void testCanvasClearing();
+    void testDisplayListItem();
+    void testDisplayListOrder();
+    void testManyGraphicsInOneItem();
+    void testGridIndex();
+    void testHeadlessRender();
 
 
 private:
@@ -294,23 +302,147 @@ void unittests_gui::testMalformedGraphicsCommands() {
 }
 
 
+void unittests_gui::testDisplayListItem() {
+    QGraphicsScene listScene;
+    auto* list = new DisplayListItem();
+    list->addLine(QLineF(0, 0, 100, 0));
+    list->addRect(QRectF(200, 200, 50, 30));
+    list->addEllipse(QRectF(-100, -50, 40, 20));
+    list->addFillRect(QRectF(300, 0, 10, 10), qRgb(0, 255, 0));
+    listScene.addItem(list);
+
+    QCOMPARE(list->size(), 4);
+    QVERIFY(list->boundingRect().contains(QPointF(310, 10)));
+
+    // hits follow the primitives, not the bounding rect
+    QVERIFY(listScene.itemAt(QPointF(50, 1), QTransform()) == list);
+    QVERIFY(listScene.itemAt(QPointF(225, 215), QTransform()) == list);
+    QVERIFY(listScene.itemAt(QPointF(-80, -40), QTransform()) == list);
+    QVERIFY(listScene.itemAt(QPointF(305, 5), QTransform()) == list);
+    QVERIFY(listScene.itemAt(QPointF(50, 10), QTransform()) == nullptr);
+    QVERIFY(listScene.itemAt(QPointF(-100, -50), QTransform()) == nullptr);
+
+    // and so do rect queries
+    QCOMPARE(listScene.items(QRectF(40, -1, 2, 2)), QList<QGraphicsItem*>({ list }));
+    QCOMPARE(listScene.items(QRectF(295, -5, 2, 2)), QList<QGraphicsItem*>());
+    QCOMPARE(listScene.items(QRectF(0, 100, 50, 50)), QList<QGraphicsItem*>());
+    QCOMPARE(listScene.items(QRectF(-200, -100, 600, 400), Qt::ContainsItemShape), QList<QGraphicsItem*>({ list }));
+    QCOMPARE(listScene.items(QRectF(-50, -100, 400, 400), Qt::ContainsItemShape), QList<QGraphicsItem*>());
+}
 
+// paint the part exposed of list onto a white image of size, one pixel a unit
+static QImage paint_exposed(DisplayListItem& list, QSize size, const QRectF& exposed) {
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = exposed;
+    list.paint(&painter, &option, nullptr);
+    return image;
+}
 
+void unittests_gui::testDisplayListOrder() {
+    // a fill rect over DisplayListMin lines, crossed by a line added after it
+    DisplayListItem list;
+    for (int i = 0; i < QtInterpreter::DisplayListMin; ++i) {
+        list.addLine(QLineF(0, i + 10, 120, i + 10));
+    }
+    list.addFillRect(QRectF(20, 20, 60, 40), qRgb(255, 0, 0));
+    list.addLine(QLineF(50, 0, 50, 100));
+
+    // painted in the order added, all of it or the part the index finds
+    QList<QRectF> exposed = { list.boundingRect(), QRectF(30, 30, 30, 10) };
+    for (const QRectF& rect : exposed) {
+        QImage image = paint_exposed(list, QSize(130, 100), rect);
+        QCOMPARE(image.pixel(40, 35), qRgb(255, 0, 0)); // the fill covers the lines
+        QCOMPARE(image.pixel(10, 35), qRgb(0, 0, 0));
+        QCOMPARE(image.pixel(50, 35), qRgb(0, 0, 0));   // the last line is on top
+    }
+}
 
+void unittests_gui::testManyGraphicsInOneItem() {
+    QVERIFY(repl && replEdit);
+    QVERIFY(canvas && scene);
 
+    // a draw of more graphics than DisplayListMin gives a single item
+    QString program = "(";
+    for (int i = 0; i < QtInterpreter::DisplayListMin; ++i) {
+        program += QString("((%1 500 point) (%1 600 point) line) ").arg(1000 + i * 10);
+    }
+    program += "draw)";
+    int items = scene->items().size();
 
+    QTest::keyClicks(replEdit, program);
+    QTest::keyClick(replEdit, Qt::Key_Return, Qt::NoModifier);
 
+    QCOMPARE(scene->items().size(), items + 1);
+    QVERIFY(dynamic_cast<DisplayListItem*>(scene->itemAt(QPointF(1000, 550), QTransform())) != nullptr);
+    QVERIFY(scene->itemAt(QPointF(1005, 550), QTransform()) == nullptr);
+}
 
+void unittests_gui::testGridIndex() {
+    GridIndex index(10);
+    QCOMPARE(index.insert(QRectF(0, 0, 5, 5)), 0u);
+    QCOMPARE(index.insert(QRectF(100, 100, -20, -20)), 1u); // normalized
+    QCOMPARE(index.insert(QRectF(-1000, 0, 2000, 1)), 2u);  // too long for the cells
+    QCOMPARE(index.insert(QRectF(3, 3, 0, 0)), 3u);
+    QCOMPARE(index.size(), 4u);
+
+    QVector<quint32> ids;
+    index.query(QRectF(1, 1, 2, 2), ids);
+    QCOMPARE(ids, QVector<quint32>({ 0, 2, 3 }));
+    index.query(QRectF(85, 85, 1, 1), ids);
+    QCOMPARE(ids, QVector<quint32>({ 1 }));
+    index.query(QRectF(-500, 50, 10, 10), ids);
+    QVERIFY(ids.isEmpty());
+    index.query(QRectF(-5000, -5000, 10000, 10000), ids); // more cells than bounds
+    QCOMPARE(ids, QVector<quint32>({ 0, 1, 2, 3 }));
+
+    index.clear();
+    index.query(QRectF(1, 1, 2, 2), ids);
+    QVERIFY(ids.isEmpty());
+}
 
-
-
-
-
-
-
-
-
-
+void unittests_gui::testHeadlessRender() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString script = dir.filePath("lines.slp");
+    QFile file(script);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    file.write("(((0 0 point) (100 100 point) line) ((0 100 point) (100 0 point) line) draw)");
+    file.close();
+
+    RenderOptions options;
+    options.input = script.toStdString();
+    options.output = dir.filePath("lines.png").toStdString();
+    options.width = 200;
+    options.height = 100;
+    QCOMPARE(render_script(options), EXIT_SUCCESS);
+
+    // the drawing is fit in the image, the crossing of the lines at its center
+    QImage image(QString::fromStdString(options.output));
+    QCOMPARE(image.size(), QSize(200, 100));
+    QVERIFY(qGray(image.pixel(100, 50)) < 128);
+    QCOMPARE(image.pixel(5, 50), qRgb(255, 255, 255));
+
+    // without Qt Svg .svg is refused
+    options.output = dir.filePath("lines.svg").toStdString();
+#ifdef PLDRAW_HAVE_SVG
+    QCOMPARE(render_script(options), EXIT_SUCCESS);
+    QVERIFY(QFileInfo(QString::fromStdString(options.output)).size() > 0);
+#else
+    QCOMPARE(render_script(options), EXIT_FAILURE);
+    QVERIFY(!QFileInfo::exists(QString::fromStdString(options.output)));
+#endif
+
+    // errors give a failing status and no file
+    options.output = dir.filePath("lines.jpg").toStdString();
+    QCOMPARE(render_script(options), EXIT_FAILURE);
+    options.input = dir.filePath("missing.slp").toStdString();
+    options.output = dir.filePath("missing.png").toStdString();
+    QCOMPARE(render_script(options), EXIT_FAILURE);
+    QVERIFY(!QFileInfo::exists(QString::fromStdString(options.output)));
+}
 
 QTEST_MAIN(unittests_gui)
 #include "unittests_gui.moc"
\ No newline at end of file